@@ -0,0 +1,75 @@
+#include "admission.h"
+
+void admission_init(admission_t *a, size_t budget) {
+    pthread_mutex_init(&a->mut, NULL);
+    pthread_cond_init(&a->freed, NULL);
+    a->budget = budget;
+    a->in_use = 0;
+    a->running = 0;
+}
+
+void admission_destroy(admission_t *a) {
+    pthread_mutex_destroy(&a->mut);
+    pthread_cond_destroy(&a->freed);
+}
+
+/**
+ * Whether a run fits, with the lock held
+ */
+static bool fits(admission_t *a, size_t bytes) {
+    return 0 == a->running || (a->in_use <= a->budget && bytes <= a->budget - a->in_use);
+}
+
+bool admission_fits(admission_t *a, size_t bytes) {
+    if (bytes < ADMISSION_SMALL) {
+        return TRUE;
+    }
+
+    pthread_mutex_lock(&a->mut);
+    bool ok = fits(a, bytes);
+    pthread_mutex_unlock(&a->mut);
+
+    return ok;
+}
+
+bool admission_try(admission_t *a, size_t bytes) {
+    if (bytes < ADMISSION_SMALL) {
+        return TRUE;
+    }
+
+    pthread_mutex_lock(&a->mut);
+    bool ok = fits(a, bytes);
+    if (ok) {
+        a->in_use += bytes;
+        a->running++;
+    }
+    pthread_mutex_unlock(&a->mut);
+
+    return ok;
+}
+
+void admission_wait(admission_t *a, size_t bytes) {
+    if (bytes < ADMISSION_SMALL) {
+        return;
+    }
+
+    pthread_mutex_lock(&a->mut);
+    while (!fits(a, bytes)) {
+        pthread_cond_wait(&a->freed, &a->mut);
+    }
+    a->in_use += bytes;
+    a->running++;
+    pthread_mutex_unlock(&a->mut);
+}
+
+void admission_release(admission_t *a, size_t bytes) {
+    if (bytes < ADMISSION_SMALL) {
+        return;
+    }
+
+    pthread_mutex_lock(&a->mut);
+    a->in_use -= bytes;
+    a->running--;
+    pthread_cond_broadcast(&a->freed);
+    pthread_mutex_unlock(&a->mut);
+}
@@ -0,0 +1,69 @@
+#ifndef COPNV2_ADMISSION_H
+#define COPNV2_ADMISSION_H
+
+#include <stdlib.h>
+#include <pthread.h>
+#include "types.h"
+
+/*
+ * Runs estimated below this do not go through admission at all: they fit in the
+ * workers' arenas and are too short to be worth the lock.
+ */
+#define ADMISSION_SMALL (1U << 20)
+
+/**
+ * Keeps the memory of the runs in progress, across all workers, under a budget.
+ * A run larger than the whole budget is only admitted when nothing else runs.
+ */
+typedef struct {
+    pthread_mutex_t mut;
+    pthread_cond_t freed;
+    size_t budget;
+    size_t in_use;
+    u32 running;
+} admission_t;
+
+/**
+ * Initialize the admission control
+ * @param a the structure
+ * @param budget the memory budget, in bytes
+ */
+void admission_init(admission_t *a, size_t budget);
+
+/**
+ * Destroy the admission control
+ * @param a the structure
+ */
+void admission_destroy(admission_t *a);
+
+/**
+ * Check, without admitting it, if a run would be admitted right now
+ * @param a the admission control
+ * @param bytes the estimated memory of the run
+ * @return if it fits
+ */
+bool admission_fits(admission_t *a, size_t bytes);
+
+/**
+ * Admit a run if it fits right now
+ * @param a the admission control
+ * @param bytes the estimated memory of the run
+ * @return if it was admitted (it must then be released)
+ */
+bool admission_try(admission_t *a, size_t bytes);
+
+/**
+ * Admit a run, waiting for memory to be released if needed
+ * @param a the admission control
+ * @param bytes the estimated memory of the run
+ */
+void admission_wait(admission_t *a, size_t bytes);
+
+/**
+ * Give back the memory of an admitted run
+ * @param a the admission control
+ * @param bytes the estimate the run was admitted with
+ */
+void admission_release(admission_t *a, size_t bytes);
+
+#endif //COPNV2_ADMISSION_H
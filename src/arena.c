@@ -0,0 +1,147 @@
+#include "arena.h"
+
+#define ARENA_ALIGN 16
+#define ARENA_PAGE 4096
+#define ARENA_HEADER ((sizeof(arena_block_t) + ARENA_ALIGN - 1) & ~((size_t) ARENA_ALIGN - 1))
+
+static arena_block_t *arena_block_new(size_t cap) {
+    arena_block_t *b = malloc(ARENA_HEADER + cap);
+    if (NULL != b) {
+        b->next = NULL;
+        b->cap = cap;
+        b->used = 0;
+    }
+    return b;
+}
+
+arena_t *arena_new(size_t initial) {
+    arena_t *a = malloc(sizeof(arena_t));
+
+    if (NULL == a) {
+        return a;
+    }
+
+    if (NULL == (a->first = arena_block_new(initial))) {
+        free(a);
+        return NULL;
+    }
+
+    a->cur = a->first;
+    a->reserved = initial;
+
+    return a;
+}
+
+void arena_destroy(arena_t *a) {
+    arena_block_t *b = a->first;
+    while (NULL != b) {
+        arena_block_t *next = b->next;
+        free(b);
+        b = next;
+    }
+    free(a);
+}
+
+void *arena_alloc(arena_t *a, size_t bytes) {
+    // Rounding up (and the block header) must not wrap around
+    if (bytes > (size_t) -1 - 2 * ARENA_HEADER - ARENA_PAGE) {
+        return NULL;
+    }
+    bytes = (bytes + ARENA_ALIGN - 1) & ~((size_t) ARENA_ALIGN - 1);
+
+    arena_block_t *b = a->cur;
+    while (b->cap - b->used < bytes) {
+        // Blocks past the current one hold nothing live
+        arena_block_t *next = b->next;
+        if (NULL == next || next->cap < bytes) {
+            // Sized to the request (small ones share blocks the size of the first), and
+            // one too small is replaced rather than skipped: the arena holds about what
+            // its largest run needed, which is what that run was admitted for
+            arena_block_t *rest = NULL;
+            if (NULL != next) {
+                rest = next->next;
+                a->reserved -= next->cap;
+                free(next);
+            }
+
+            size_t cap = (bytes + ARENA_PAGE - 1) & ~((size_t) ARENA_PAGE - 1);
+            if (cap < a->first->cap) {
+                cap = a->first->cap;
+            }
+            if (NULL == (b->next = arena_block_new(cap))) {
+                b->next = rest;
+                return NULL;
+            }
+            b->next->next = rest;
+            a->reserved += cap;
+        }
+        b = b->next;
+        b->used = 0;
+    }
+
+    a->cur = b;
+    void *p = (u8 *) b + ARENA_HEADER + b->used;
+    b->used += bytes;
+
+    return p;
+}
+
+void arena_reset(arena_t *a) {
+    a->cur = a->first;
+    a->first->used = 0;
+}
+
+void arena_trim(arena_t *a, size_t keep) {
+    arena_reset(a);
+
+    if (a->reserved <= keep) {
+        return;
+    }
+
+    arena_block_t *b = a->first->next;
+    while (NULL != b) {
+        arena_block_t *next = b->next;
+        free(b);
+        b = next;
+    }
+
+    a->first->next = NULL;
+    a->reserved = a->first->cap;
+}
+
+arena_mark_t arena_mark(arena_t *a) {
+    arena_mark_t m = {a->cur, a->cur->used};
+    return m;
+}
+
+void arena_release(arena_t *a, arena_mark_t m) {
+    a->cur = m.block;
+    a->cur->used = m.used;
+}
+
+void *mem_alloc(arena_t *a, size_t bytes) {
+    return NULL != a ? arena_alloc(a, bytes) : malloc(bytes);
+}
+
+void *mem_alloc_array(arena_t *a, u64 count, size_t size) {
+    size_t bytes;
+    if (!size_mul(&bytes, count, size)) {
+        return NULL;
+    }
+    return mem_alloc(a, bytes);
+}
+
+bool size_mul(size_t *out, u64 a, u64 b) {
+    u64 product;
+    if (__builtin_mul_overflow(a, b, &product) || product > (size_t) -1) {
+        return FALSE;
+    }
+    *out = (size_t) product;
+    return TRUE;
+}
+
+void mem_free(arena_t *a, void *p) {
+    if (NULL == a) {
+        free(p);
+    }
+}
@@ -0,0 +1,113 @@
+#ifndef COPNV2_ARENA_H
+#define COPNV2_ARENA_H
+
+#include <stdlib.h>
+#include "types.h"
+
+/**
+ * A growable bump allocator. Allocations are never freed one by one: the whole
+ * arena is reset (or rolled back to a mark) at once, and its memory is kept for
+ * the next use. Each worker owns one, so there is no contention on it.
+ */
+typedef struct arena_block {
+    struct arena_block *next;
+    size_t cap;
+    size_t used;
+} arena_block_t;
+
+typedef struct {
+    arena_block_t *first;
+    arena_block_t *cur;
+    // Bytes held in all the blocks
+    size_t reserved;
+} arena_t;
+
+typedef struct {
+    arena_block_t *block;
+    size_t used;
+} arena_mark_t;
+
+/**
+ * Create an arena
+ * @param initial the size of the first block, in bytes
+ * @return the arena, or null if allocation failed
+ */
+arena_t *arena_new(size_t initial);
+
+/**
+ * Free all the memory of the arena
+ * @param a the arena
+ */
+void arena_destroy(arena_t *a);
+
+/**
+ * Allocate memory from the arena (16 bytes aligned)
+ * @param a the arena
+ * @param bytes the size wanted
+ * @return the memory, or null if allocation failed
+ */
+void *arena_alloc(arena_t *a, size_t bytes);
+
+/**
+ * Forget all the allocations, keeping the memory for reuse
+ * @param a the arena
+ */
+void arena_reset(arena_t *a);
+
+/**
+ * Reset the arena, and give its memory back to the system if it holds more than
+ * it should keep (the first block is always kept)
+ * @param a the arena
+ * @param keep how many bytes the arena may hold on to
+ */
+void arena_trim(arena_t *a, size_t keep);
+
+/**
+ * Remember where the arena is at, to roll back to it later
+ * @param a the arena
+ * @return the mark
+ */
+arena_mark_t arena_mark(arena_t *a);
+
+/**
+ * Forget all the allocations done since the mark was taken
+ * @param a the arena
+ * @param m the mark
+ */
+void arena_release(arena_t *a, arena_mark_t m);
+
+/**
+ * Allocate from the arena if there is one, from the heap otherwise
+ * @param a the arena (may be null)
+ * @param bytes the size wanted
+ * @return the memory, or null if allocation failed
+ */
+void *mem_alloc(arena_t *a, size_t bytes);
+
+/**
+ * Allocate an array from the arena if there is one, from the heap otherwise. Fails
+ * rather than wrapping around when count * size does not fit in a size_t.
+ * @param a the arena (may be null)
+ * @param count the number of elements
+ * @param size the size of an element
+ * @return the memory, or null if the size overflows or allocation failed
+ */
+void *mem_alloc_array(arena_t *a, u64 count, size_t size);
+
+/**
+ * Multiply two sizes, checking for overflow
+ * @param out where to store a * b
+ * @param a a
+ * @param b b
+ * @return if a * b fits in a size_t (out is untouched otherwise)
+ */
+bool size_mul(size_t *out, u64 a, u64 b);
+
+/**
+ * Free memory from mem_alloc. Arena memory is only reclaimed on reset.
+ * @param a the arena the memory came from (may be null)
+ * @param p the memory
+ */
+void mem_free(arena_t *a, void *p);
+
+#endif //COPNV2_ARENA_H
@@ -1,18 +1,22 @@
 #include "bitset.h"
 #include <stdlib.h>
 
-bitset_t *new_bitset(u32 bits) {
-    u32 no_of_blocks = (bits / BITSET_WIDTH) + ((bits % BITSET_WIDTH) > 0);
+bitset_t *new_bitset(u64 bits) {
+    return new_bitset_in(NULL, bits);
+}
+
+bitset_t *new_bitset_in(arena_t *arena, u64 bits) {
+    u64 no_of_blocks = (bits / BITSET_WIDTH) + ((bits % BITSET_WIDTH) > 0);
     bitset_t *field;
-    if (NULL != (field = malloc(sizeof(bitset_t)))) {
-        if (NULL != (field->parts = malloc(sizeof(BITSET_DATA_UNIT) * no_of_blocks))) {
+    if (NULL != (field = mem_alloc(arena, sizeof(bitset_t)))) {
+        if (NULL != (field->parts = mem_alloc_array(arena, no_of_blocks, sizeof(BITSET_DATA_UNIT)))) {
             field->l = no_of_blocks;
             field->bits = bits;
-            for (u32 i = 0; i < no_of_blocks; ++i) {
+            for (u64 i = 0; i < no_of_blocks; ++i) {
                 field->parts[i] = 0x00;
             }
         } else {
-            free(field);
+            mem_free(arena, field);
             field = NULL;
         }
     }
@@ -23,7 +27,7 @@ bitset_t *new_bitset(u32 bits) {
 bitset_t *bitset_clone(bitset_t *left) {
     bitset_t *new = new_bitset(left->bits);
 
-    for (u32 i = 0; i < left->l; ++i) {
+    for (u64 i = 0; i < left->l; ++i) {
         new->parts[i] = left->parts[i];
     }
 
@@ -43,10 +47,10 @@ bitset_t *bitset_destroy(bitset_t *left) {
 
 bool bitset_or(bitset_t *left, bitset_t *right) {
     bool change = 0;
-    u32 l = left->l;
+    u64 l = left->l;
     BITSET_DATA_UNIT *a = left->parts;
     BITSET_DATA_UNIT *b = right->parts;
-    for (u32 i = 0; i < l; ++i) {
+    for (u64 i = 0; i < l; ++i) {
         BITSET_DATA_UNIT old = a[i];
         a[i] |= b[i];
         change |= (old != a[i]);
@@ -56,10 +60,10 @@ bool bitset_or(bitset_t *left, bitset_t *right) {
 
 bool bitset_and(bitset_t *left, bitset_t *right) {
     bool change = 0U;
-    u32 l = left->l;
+    u64 l = left->l;
     BITSET_DATA_UNIT *a = left->parts;
     BITSET_DATA_UNIT *b = right->parts;
-    for (u32 i = 0; i < l; ++i) {
+    for (u64 i = 0; i < l; ++i) {
         BITSET_DATA_UNIT old = a[i];
         a[i] &= b[i];
         change |= (a[i] != old);
@@ -68,17 +72,21 @@ bool bitset_and(bitset_t *left, bitset_t *right) {
 }
 
 bitset_t *bitset_not(bitset_t *left, bitset_t *right) {
-    u32 l = right->l;
+    u64 l = right->l;
     BITSET_DATA_UNIT *a = left->parts;
     BITSET_DATA_UNIT *b = right->parts;
-    for (u32 i = 0; i < l; ++i) {
+    for (u64 i = 0; i < l; ++i) {
         a[i] = ~b[i];
     }
+    // Keep the bits past the end of the universe down, so emptiness checks hold
+    if (right->bits % BITSET_WIDTH) {
+        a[l - 1] &= (1U << (right->bits % BITSET_WIDTH)) - 1U;
+    }
     return left;
 }
 
-u8 bitset_set(bitset_t *left, u32 bit, i8 val) {
-    u32 addr = bit / BITSET_WIDTH;
+u8 bitset_set(bitset_t *left, u64 bit, i8 val) {
+    u64 addr = bit / BITSET_WIDTH;
     u8 offset = bit % BITSET_WIDTH;
     BITSET_DATA_UNIT block = left->parts[addr];
     u8 previous = (block & (1U << offset)) > 0;
@@ -93,14 +101,20 @@ u8 bitset_set(bitset_t *left, u32 bit, i8 val) {
 }
 
 u32 *bitset_indices(bitset_t *b, u32 *vertex_count) {
-    u32 sz = 0;
-    u32 bits = b->bits;
-
-    u32 *s = malloc(sizeof(u32) * bits);
+    u32 *s = mem_alloc_array(NULL, b->bits, sizeof(u32));
     if (!s) { return s; }
 
-    u32 index = 0;
-    u32 i = 0;
+    *vertex_count = bitset_indices_into(b, s);
+
+    return s;
+}
+
+u32 bitset_indices_into(bitset_t *b, u32 *s) {
+    u32 sz = 0;
+    u64 bits = b->bits;
+
+    u64 index = 0;
+    u64 i = 0;
     while (i < b->l && index < bits) {
         BITSET_DATA_UNIT block = b->parts[i++];
         if (block > 0) {
@@ -114,15 +128,13 @@ u32 *bitset_indices(bitset_t *b, u32 *vertex_count) {
         index += BITSET_WIDTH;
     }
 
-    *vertex_count = sz;
-
-    return s;
+    return sz;
 }
 
 u32 bitset_sum(bitset_t *b) {
     u32 s = 0;
 
-    for (u32 i = 0; i < b->l; ++i) {
+    for (u64 i = 0; i < b->l; ++i) {
         s += b->parts[i];
     }
 
@@ -131,7 +143,7 @@ u32 bitset_sum(bitset_t *b) {
 
 bool bitset_any(bitset_t *b) {
     bool any = FALSE;
-    for (u32 i = 0; i < b->l; ++i) {
+    for (u64 i = 0; i < b->l; ++i) {
         if (b->parts[i] > 0) {
             any = TRUE;
             break;
@@ -141,11 +153,37 @@ bool bitset_any(bitset_t *b) {
 }
 
 void bitset_all(bitset_t *b, bool v) {
-    for (u32 i = 0; i < b->bits; ++i) {
+    for (u64 i = 0; i < b->bits; ++i) {
         bitset_set(b, i, v);
     }
 }
 
+u32 bitset_count(bitset_t *b) {
+    u32 count = 0;
+    for (u64 i = 0; i < b->l; ++i) {
+        count += __builtin_popcount(b->parts[i]);
+    }
+    return count;
+}
+
+u32 bitset_count_and(bitset_t *a, bitset_t *b) {
+    u32 count = 0;
+    for (u64 i = 0; i < a->l; ++i) {
+        count += __builtin_popcount(a->parts[i] & b->parts[i]);
+    }
+    return count;
+}
+
+bool bitset_first(bitset_t *b, u32 *index) {
+    for (u64 i = 0; i < b->l; ++i) {
+        if (b->parts[i]) {
+            *index = i * BITSET_WIDTH + __builtin_ctz(b->parts[i]);
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
 bool bitset_eqs(bitset_t *a, bitset_t *b) {
     bool eq = TRUE;
     if (b->l > a->l) {
@@ -155,8 +193,8 @@ bool bitset_eqs(bitset_t *a, bitset_t *b) {
     }
 
     // We can assume |a| < |b|
-    u32 scout = 0;
-    u32 l = a->l;
+    u64 scout = 0;
+    u64 l = a->l;
     for (; scout < l; ++scout) {
         if (a->parts[scout] != b->parts[scout]) {
             eq = FALSE;
@@ -1,6 +1,7 @@
 #ifndef COPNV2_BITFIELD_H
 
 #include "types.h"
+#include "arena.h"
 
 /* These definition allow the width of a block within a bitset
  * to be changed. In theory, wider blocks should be faster since
@@ -18,8 +19,8 @@
  */
 typedef struct {
     BITSET_DATA_UNIT *parts;
-    u32 l;
-    u32 bits;
+    u64 l;
+    u64 bits;
 } bitset_t;
 
 /**
@@ -27,7 +28,16 @@ typedef struct {
  * @param bits the number of bits in the set (size of the universe set)
  * @return pointer to allocated structure
  */
-bitset_t *new_bitset(u32 bits);
+bitset_t *new_bitset(u64 bits);
+
+/**
+ * Create a bitset from an arena (or the heap if the arena is null). Bitsets from an
+ * arena must not be destroyed; they go away with the arena's reset.
+ * @param arena the arena
+ * @param bits the number of bits in the set (size of the universe set)
+ * @return pointer to allocated structure
+ */
+bitset_t *new_bitset_in(arena_t *arena, u64 bits);
 
 /**
  * Logical 'or' the right bitfield into the left bitfield.
@@ -75,7 +85,7 @@ bitset_t *bitset_not(bitset_t *left, bitset_t *right);
  * @param val -1 for no change, 0 or 1 as the value to set
  * @return the value previously affected to the bit
  */
-u8 bitset_set(bitset_t *left, u32 bit, i8 val);
+u8 bitset_set(bitset_t *left, u64 bit, i8 val);
 
 /**
  * Destroy the bitfield bitset_and free it
@@ -85,7 +95,8 @@ u8 bitset_set(bitset_t *left, u32 bit, i8 val);
 bitset_t *bitset_destroy(bitset_t *left);
 
 /**
- * Compute the list of indices that are set in the bitset
+ * Compute the list of indices that are set in the bitset. Indices are u32: this is
+ * meant for sets of vertices, not of positions.
  * @param left the bitset in question
  * @param a pointer to a u32 where the number of elements in the indice set
  * will be stored
@@ -93,6 +104,14 @@ bitset_t *bitset_destroy(bitset_t *left);
  */
 u32 *bitset_indices(bitset_t *left, u32 *vertex_count);
 
+/**
+ * Compute the list of indices that are set in the bitset, into a given buffer
+ * @param b the bitset in question
+ * @param s the buffer, wide enough for every bit that is up
+ * @return the number of elements in the indice set
+ */
+u32 bitset_indices_into(bitset_t *b, u32 *s);
+
 /**
  * Compute the sum of the parts of the bitset. The actual value of the sum does not mean
  * anything special and you should not rely on the value, except for the following values:
@@ -118,6 +137,29 @@ void bitset_all(bitset_t *b, bool v);
 bool bitset_any(bitset_t *b);
 
 
+/**
+ * Count the bits that are up
+ * @param b the bitset
+ * @return |B|
+ */
+u32 bitset_count(bitset_t *b);
+
+/**
+ * Count the bits that are up in both bitsets, without building the intersection
+ * @param a A
+ * @param b B
+ * @return |A \cap B|
+ */
+u32 bitset_count_and(bitset_t *a, bitset_t *b);
+
+/**
+ * Find the lowest bit that is up
+ * @param b the bitset
+ * @param index where to store the index of the bit
+ * @return if there was a bit up (index is untouched otherwise)
+ */
+bool bitset_first(bitset_t *b, u32 *index);
+
 /**
  * Verify that two bitsets are equal. They need not be the same size, but the longer one
  * must have null data after the end of the "first one".
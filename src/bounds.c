@@ -0,0 +1,232 @@
+#include "bounds.h"
+#include <stdlib.h>
+#include "bitset.h"
+
+const char *bound_name(bound_kind_t kind) {
+    switch (kind) {
+        case BOUND_FOREST:
+            return "forest";
+        case BOUND_DOMINATING:
+            return "dominating-set";
+        case BOUND_ISOMETRIC_PATHS:
+            return "isometric-paths";
+        default:
+            return "fixed-point";
+    }
+}
+
+/**
+ * Breadth first search restricted to a subset of vertices
+ * @param g the graph
+ * @param alive the vertices that can be visited
+ * @param source where to start (must be alive)
+ * @param order filled with the visited vertices, in visit order
+ * @param dist filled with the distance to each visited vertex (indexed by vertex)
+ * @param parent filled with the BFS tree parent of each visited vertex (indexed by vertex)
+ * @return the number of vertices visited
+ */
+static u32 bfs(graph_t *g, bitset_t *alive, u32 source, u32 *order, u32 *dist, u32 *parent) {
+    bitset_t *seen = new_bitset(g->n);
+    u32 lo = 0, hi = 0;
+
+    order[hi++] = source;
+    dist[source] = 0;
+    parent[source] = source;
+    bitset_set(seen, source, 1);
+
+    while (lo < hi) {
+        u32 v = order[lo++];
+        BITSET_DATA_UNIT *row = g->rows[v]->parts;
+
+        for (u32 i = 0; i < seen->l; ++i) {
+            BITSET_DATA_UNIT block = row[i] & alive->parts[i] & ~seen->parts[i];
+            seen->parts[i] |= block;
+            while (block) {
+                u32 w = i * BITSET_WIDTH + __builtin_ctz(block);
+                block &= block - 1;
+                order[hi++] = w;
+                dist[w] = dist[v] + 1;
+                parent[w] = v;
+            }
+        }
+    }
+
+    bitset_destroy(seen);
+    return hi;
+}
+
+/**
+ * Size of a dominating set of the alive vertices, built greedily by repeatedly taking
+ * the vertex that covers the most uncovered vertices.
+ * @param g the graph
+ * @param alive the vertices to dominate (and to dominate with)
+ * @return the size of the set found
+ */
+static u32 greedy_dominating(graph_t *g, bitset_t *alive) {
+    bitset_t *uncovered = bitset_clone(alive);
+    u32 size = 0;
+
+    while (bitset_any(uncovered)) {
+        u32 best = 0, best_cover = 0;
+        for (u32 v = 0; v < g->n; ++v) {
+            if (!bitset_set(alive, v, READ_ONLY)) {
+                continue;
+            }
+            u32 cover = bitset_count_and(g->rows[v], uncovered);
+            if (cover > best_cover) {
+                best_cover = cover;
+                best = v;
+            }
+        }
+
+        bitset_t *row = g->rows[best];
+        for (u32 i = 0; i < uncovered->l; ++i) {
+            uncovered->parts[i] &= ~row->parts[i];
+        }
+        size++;
+    }
+
+    bitset_destroy(uncovered);
+    return size;
+}
+
+/**
+ * Upper bound for a robber confined to the connected set of vertices H. One cop guards
+ * a longest geodesic we can find in H, which confines the robber to one component of
+ * what remains; the other cops then work on that component. At any point the cops
+ * can instead occupy a dominating set of H.
+ * @param g the graph
+ * @param H a non-empty connected set of vertices (consumed)
+ * @param order scratch, n wide
+ * @param dist scratch, n wide
+ * @param parent scratch, n wide
+ * @return the bound
+ */
+static u32 isometric_paths(graph_t *g, bitset_t *H, u32 *order, u32 *dist, u32 *parent) {
+    u32 dominating = greedy_dominating(g, H);
+    if (dominating <= 1) {
+        bitset_destroy(H);
+        return dominating;
+    }
+
+    u32 first;
+    bitset_first(H, &first);
+
+    // Double sweep: the farthest vertex from anywhere, then the farthest from it
+    u32 visited = bfs(g, H, first, order, dist, parent);
+    u32 a = order[visited - 1];
+    visited = bfs(g, H, a, order, dist, parent);
+    u32 b = order[visited - 1];
+
+    // Any shortest path is isometric
+    for (u32 v = b; v != a; v = parent[v]) {
+        bitset_set(H, v, 0);
+    }
+    bitset_set(H, a, 0);
+
+    u32 worst = 0;
+    while (bitset_any(H)) {
+        u32 source;
+        bitset_first(H, &source);
+        u32 sz = bfs(g, H, source, order, dist, parent);
+
+        bitset_t *component = new_bitset(g->n);
+        for (u32 i = 0; i < sz; ++i) {
+            bitset_set(component, order[i], 1);
+            bitset_set(H, order[i], 0);
+        }
+
+        u32 c = isometric_paths(g, component, order, dist, parent);
+        if (c > worst) {
+            worst = c;
+        }
+    }
+
+    bitset_destroy(H);
+
+    return (1 + worst) < dominating ? (1 + worst) : dominating;
+}
+
+u32 cop_lower_bound(graph_t *g) {
+    u32 n = g->n;
+    u32 components = 0;
+
+    u32 *order = malloc(sizeof(u32) * n);
+    u32 *dist = malloc(sizeof(u32) * n);
+    u32 *parent = malloc(sizeof(u32) * n);
+    bitset_t *alive = new_bitset(n);
+    bitset_all(alive, TRUE);
+
+    while (bitset_any(alive)) {
+        u32 source;
+        bitset_first(alive, &source);
+        u32 sz = bfs(g, alive, source, order, dist, parent);
+        for (u32 i = 0; i < sz; ++i) {
+            bitset_set(alive, order[i], 0);
+        }
+        components++;
+    }
+
+    bitset_destroy(alive);
+    free(order);
+    free(dist);
+    free(parent);
+
+    return components;
+}
+
+cop_bound_t cop_upper_bound(graph_t *g) {
+    u32 n = g->n;
+    cop_bound_t bound = {n, BOUND_DOMINATING};
+
+    u32 *order = malloc(sizeof(u32) * n);
+    u32 *dist = malloc(sizeof(u32) * n);
+    u32 *parent = malloc(sizeof(u32) * n);
+    bitset_t *alive = new_bitset(n);
+    bitset_all(alive, TRUE);
+
+    // The rows are reflexive: every vertex counts itself once
+    u32 degrees = 0;
+    for (u32 v = 0; v < n; ++v) {
+        degrees += bitset_count(g->rows[v]) - 1;
+    }
+    u32 edges = degrees / 2;
+
+    bound.value = greedy_dominating(g, alive);
+
+    u32 components = 0;
+    u32 paths = 0;
+    while (bitset_any(alive)) {
+        u32 source;
+        bitset_first(alive, &source);
+        u32 sz = bfs(g, alive, source, order, dist, parent);
+
+        bitset_t *component = new_bitset(n);
+        for (u32 i = 0; i < sz; ++i) {
+            bitset_set(component, order[i], 1);
+            bitset_set(alive, order[i], 0);
+        }
+        components++;
+
+        // The robber picks one component, but the cops have to be ready for all of them
+        paths += isometric_paths(g, component, order, dist, parent);
+    }
+
+    if (paths < bound.value) {
+        bound.value = paths;
+        bound.kind = BOUND_ISOMETRIC_PATHS;
+    }
+
+    // A forest is exactly as many cops as trees; prefer saying so
+    if (edges + components == n && components <= bound.value) {
+        bound.value = components;
+        bound.kind = BOUND_FOREST;
+    }
+
+    bitset_destroy(alive);
+    free(order);
+    free(dist);
+    free(parent);
+
+    return bound;
+}
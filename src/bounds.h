@@ -0,0 +1,54 @@
+#ifndef COPNV2_BOUNDS_H
+#define COPNV2_BOUNDS_H
+
+#include "types.h"
+#include "graph.h"
+
+/**
+ * The cheap arguments that can settle a cop number without running the fixed point.
+ */
+typedef enum {
+    // No bound decided, the fixed point did
+    BOUND_NONE = 0,
+    // A forest needs exactly one cop per tree
+    BOUND_FOREST,
+    // Cops placed on a dominating set capture on their first move: c(G) <= gamma(G)
+    BOUND_DOMINATING,
+    // One cop guards an isometric path, cutting the robber off (Aigner & Fromme)
+    BOUND_ISOMETRIC_PATHS,
+    BOUND_KINDS
+} bound_kind_t;
+
+typedef struct {
+    u32 value;
+    bound_kind_t kind;
+} cop_bound_t;
+
+/**
+ * Compute the number of connected components of the graph. Since the robber picks
+ * where to start after the cops, each component needs a cop: this is a lower bound
+ * on the cop number.
+ * @param g the graph
+ * @return the number of components
+ */
+u32 cop_lower_bound(graph_t *g);
+
+/**
+ * Compute the best of the upper bounds we know how to get cheaply:
+ *  - if the graph is a forest, its number of trees (which is exact);
+ *  - the size of a greedy dominating set;
+ *  - per component, one cop per isometric path removed until what the robber
+ *    is confined to is small enough to dominate.
+ * @param g the graph
+ * @return the bound and which argument gave it
+ */
+cop_bound_t cop_upper_bound(graph_t *g);
+
+/**
+ * A printable name for a bound kind
+ * @param kind the kind
+ * @return a static string
+ */
+const char *bound_name(bound_kind_t kind);
+
+#endif //COPNV2_BOUNDS_H
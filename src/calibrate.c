@@ -0,0 +1,112 @@
+#include "calibrate.h"
+#include <stdlib.h>
+#include <time.h>
+#include "solver.h"
+
+// Graphs measured per size and density
+#define CALIBRATION_SAMPLES 8
+// Sizes in a row where the sweep must win before we stop growing
+#define CALIBRATION_STREAK 3
+// Below this many states the sweep winning says nothing about larger graphs; keep growing
+#define CALIBRATION_MIN_STATES 4096
+// Never materialize past this many states, whatever the measurements say
+#define CALIBRATION_MAX_STATES 40000
+
+/**
+ * A random graph where each edge is present with a given probability
+ * @param n the number of vertices
+ * @param p the probability of an edge
+ * @param seed the state of the generator
+ * @return the graph
+ */
+static graph_t *random_graph(u32 n, double p, unsigned int *seed) {
+    graph_t *g = new_graph(n, TRUE);
+    for (u32 j = 1; j < n; ++j) {
+        for (u32 i = 0; i < j; ++i) {
+            if ((double) rand_r(seed) / RAND_MAX < p) {
+                edge_get_and_set(g, i, j, EDGE);
+            }
+        }
+    }
+    graph_index(g);
+    return g;
+}
+
+/**
+ * Time one engine on a graph
+ * @return the wall time, in seconds
+ */
+static double time_engine(graph_t *g, u8 k, solver_ctx_t *ctx, engine_t e) {
+    struct timespec before, after;
+    ctx->engine = e;
+
+    clock_gettime(CLOCK_MONOTONIC, &before);
+    bonato_al_algo2(g, k, ctx);
+    clock_gettime(CLOCK_MONOTONIC, &after);
+
+    return (double) (after.tv_sec - before.tv_sec) + (double) (after.tv_nsec - before.tv_nsec) / 1e9;
+}
+
+/**
+ * Find the largest state space where the materialized engine beats the sweep
+ * @param p the edge probability of the graphs measured
+ * @param log where to report (may be null)
+ * @return the threshold, in states
+ */
+static u32 crossover(double p, FILE *log) {
+    unsigned int seed = 0xC0FFEE;
+    arena_t *arena = arena_new(1U << 20);
+    engine_tuning_t unused;
+    tuning_default(&unused);
+    solver_ctx_t ctx = {
+            .arena = arena,
+            .resident_budget = (size_t) -1,
+            .engine = ENGINE_AUTO,
+            .tuning = &unused,
+            .decided = BOUND_NONE,
+            .quiet = TRUE,
+            .worklist = WORKLIST_AUTO
+    };
+
+    u32 threshold = 0;
+    for (u8 k = 1; k <= 3; ++k) {
+        u32 streak = 0;
+        // Sizes grow by an eighth, so that k = 1 reaches the minimum in a few dozen steps
+        for (u32 n = 3; streak < CALIBRATION_STREAK && ipow(n, k) <= CALIBRATION_MAX_STATES; n += 1 + n / 8) {
+            double materialized = 0, sweep = 0;
+
+            for (u32 s = 0; s < CALIBRATION_SAMPLES; ++s) {
+                graph_t *g = random_graph(n, p, &seed);
+                materialized += time_engine(g, k, &ctx, ENGINE_MATERIALIZED);
+                // What the automatic selection would run instead of materializing
+                sweep += time_engine(g, k, &ctx, n <= WORD_BITS ? ENGINE_WORD : ENGINE_SWEEP);
+                destroy_graph(g);
+                arena_trim(arena, 64U << 20);
+            }
+
+            if (NULL != log) {
+                fprintf(log, "p=%.2f k=%u n=%u states=%u materialized=%.6fs sweep=%.6fs\n",
+                        p, k, n, (u32) ipow(n, k), materialized, sweep);
+            }
+
+            if (materialized < sweep) {
+                streak = 0;
+                if (ipow(n, k) > threshold) {
+                    threshold = (u32) ipow(n, k);
+                }
+            } else if (ipow(n, k) >= CALIBRATION_MIN_STATES) {
+                streak++;
+            }
+        }
+    }
+
+    arena_destroy(arena);
+
+    return threshold;
+}
+
+void tuning_calibrate(engine_tuning_t *t, FILE *log) {
+    tuning_default(t);
+    t->materialize_max_states_sparse = crossover(t->dense_density / 2, log);
+    t->materialize_max_states_dense = crossover((1 + t->dense_density) / 2, log);
+}
@@ -0,0 +1,17 @@
+#ifndef COPNV2_CALIBRATE_H
+#define COPNV2_CALIBRATE_H
+
+#include <stdio.h>
+#include "tuning.h"
+
+/**
+ * Measure the engine selection thresholds on this host. Random graphs of growing
+ * size, sparse and dense, are solved with the materialized and the sweep engines;
+ * the thresholds are set to the largest state space where building the tensor
+ * graph was still faster.
+ * @param t the tuning to fill
+ * @param log where to report the measurements (may be null)
+ */
+void tuning_calibrate(engine_tuning_t *t, FILE *log);
+
+#endif //COPNV2_CALIBRATE_H
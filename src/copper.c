@@ -0,0 +1,342 @@
+#include "copper.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "solver.h"
+#include "graph6.h"
+#include "tuning.h"
+
+// Working memory a thread starts with, and keeps between graphs
+#define COPPER_ARENA_SIZE (1U << 20)
+#define COPPER_ARENA_KEEP (64U << 20)
+
+struct copper_graph {
+    graph_t *g;
+};
+
+void copper_options_default(copper_options_t *options) {
+    options->version = COPPER_API_VERSION;
+    options->max_k = 4;
+    options->engine = NULL;
+    options->resident_budget = (size_t) 1024 << 20;
+    options->scratch_dir = NULL;
+    options->workers = 1;
+    options->worklist = NULL;
+    options->time_budget = 0;
+    options->pop_budget = 0;
+    options->dominance = 0;
+    options->run_threads = 1;
+}
+
+copper_graph_t *copper_graph_from_adjacency(unsigned int n, const unsigned char *adjacency) {
+    copper_graph_t *graph = malloc(sizeof(copper_graph_t));
+    if (NULL == graph) {
+        return NULL;
+    }
+
+    if (NULL == (graph->g = new_graph(n, TRUE))) {
+        free(graph);
+        return NULL;
+    }
+
+    for (u32 i = 0; i < n; ++i) {
+        for (u32 j = i + 1; j < n; ++j) {
+            if (adjacency[(size_t) i * n + j]) {
+                edge_get_and_set(graph->g, i, j, EDGE);
+            }
+        }
+    }
+    graph_index(graph->g);
+
+    return graph;
+}
+
+/**
+ * Check that a buffer is a whole graph6 encoding, since from_g6 trusts its input
+ * @param g6 the encoding
+ * @param len its length, without the line terminator
+ * @return if it can be decoded
+ */
+static bool g6_valid(const char *g6, size_t len) {
+    for (size_t b = 0; b < len; ++b) {
+        if (g6[b] < 63 || g6[b] > 126) {
+            return FALSE;
+        }
+    }
+
+    // The vertex count takes 1, 4 or 8 bytes
+    size_t header = 1;
+    if (len > 0 && 126 == g6[0]) {
+        header = (len > 1 && 126 == g6[1]) ? 8 : 4;
+    }
+    if (len < header) {
+        return FALSE;
+    }
+
+    size_t start;
+    u8 head[8];
+    for (size_t b = 0; b < header; ++b) {
+        head[b] = g6[b] - 63;
+    }
+    u64 n = g6_len(head, &start);
+
+    return n <= G6_MAX_VERTICES && len >= header + (n * (n - 1) / 2 + 5) / 6;
+}
+
+copper_graph_t *copper_graph_from_g6(const char *g6, size_t len) {
+    if (NULL == g6) {
+        return NULL;
+    }
+
+    while (len > 0 && ('\n' == g6[len - 1] || '\r' == g6[len - 1])) {
+        len--;
+    }
+
+    if (!g6_valid(g6, len)) {
+        return NULL;
+    }
+
+    // from_g6 wants a string
+    char *line = malloc(len + 1);
+    copper_graph_t *graph = malloc(sizeof(copper_graph_t));
+    if (NULL == line || NULL == graph) {
+        free(line);
+        free(graph);
+        return NULL;
+    }
+    memcpy(line, g6, len);
+    line[len] = '\0';
+
+    graph->g = from_g6(line);
+    free(line);
+
+    if (NULL == graph->g) {
+        free(graph);
+        return NULL;
+    }
+
+    return graph;
+}
+
+unsigned int copper_graph_order(const copper_graph_t *g) {
+    return g->g->n;
+}
+
+void copper_graph_destroy(copper_graph_t *g) {
+    if (NULL != g) {
+        destroy_graph(g->g);
+        free(g);
+    }
+}
+
+/**
+ * Solve a graph with a context set up by the caller
+ * @param g the graph
+ * @param options the options (already checked)
+ * @param ctx the solver context
+ * @param result the answer
+ * @return result->status
+ */
+static copper_status_t solve(const copper_graph_t *g, const copper_options_t *options, solver_ctx_t *ctx,
+                             copper_result_t *result) {
+    struct timespec before, after;
+
+    clock_gettime(CLOCK_MONOTONIC, &before);
+    u32 k = cop_number(g->g, options->max_k, ctx);
+    clock_gettime(CLOCK_MONOTONIC, &after);
+
+    result->cop_number = k;
+    result->decided_by = bound_name(ctx->decided);
+    result->fixed_point_runs = ctx->runs;
+    result->worklist_pops = ctx->pops;
+    result->seconds = (double) (after.tv_sec - before.tv_sec) + (double) (after.tv_nsec - before.tv_nsec) / 1e9;
+
+    if (0 != ctx->timeout_k) {
+        result->cop_number = ctx->timeout_k;
+        result->status = COPPER_TIMEOUT;
+    } else if (ctx->refused) {
+        result->status = COPPER_REFUSED;
+    } else if (k > options->max_k) {
+        result->status = COPPER_OVER;
+    } else {
+        result->status = COPPER_OK;
+    }
+
+    return result->status;
+}
+
+/**
+ * Validate the options, and turn them into a solver context (the arena is left to the caller)
+ * @param options the options (null for the defaults)
+ * @param defaults where to put the defaults if needed
+ * @param tuning the tuning to point the context to
+ * @param ctx the context to fill
+ * @return the options to use, or null if they are invalid
+ */
+static const copper_options_t *setup(const copper_options_t *options, copper_options_t *defaults,
+                                     engine_tuning_t *tuning, solver_ctx_t *ctx) {
+    if (NULL == options) {
+        copper_options_default(defaults);
+        options = defaults;
+    }
+
+    // Options filled for another layout would be misread
+    if (COPPER_API_VERSION != options->version) {
+        return NULL;
+    }
+
+    // cop_number counts cops in a u8
+    if (0 == options->max_k || options->max_k > 254) {
+        return NULL;
+    }
+
+    memset(ctx, 0, sizeof(solver_ctx_t));
+    ctx->engine = ENGINE_AUTO;
+    if (NULL != options->engine && !engine_from_name(options->engine, &ctx->engine)) {
+        return NULL;
+    }
+    ctx->worklist = WORKLIST_AUTO;
+    if (NULL != options->worklist && !worklist_from_name(options->worklist, &ctx->worklist)) {
+        return NULL;
+    }
+
+    tuning_default(tuning);
+    ctx->tuning = tuning;
+    ctx->scratch_dir = options->scratch_dir;
+    ctx->resident_budget = options->resident_budget;
+    ctx->time_budget = options->time_budget;
+    ctx->pop_budget = options->pop_budget;
+    ctx->dominance = 0 != options->dominance;
+    ctx->threads = options->run_threads;
+    ctx->decided = BOUND_NONE;
+    ctx->quiet = TRUE;
+
+    return options;
+}
+
+copper_status_t copper_cop_number(const copper_graph_t *g, const copper_options_t *options,
+                                  copper_result_t *result) {
+    copper_options_t defaults;
+    engine_tuning_t tuning;
+    solver_ctx_t ctx;
+
+    memset(result, 0, sizeof(copper_result_t));
+    result->status = COPPER_INVALID;
+
+    if (NULL == g || NULL == (options = setup(options, &defaults, &tuning, &ctx))) {
+        return COPPER_INVALID;
+    }
+
+    // A single graph: the heap is as good as an arena
+    return solve(g, options, &ctx, result);
+}
+
+/**
+ * What the threads of a batch share
+ */
+typedef struct {
+    copper_graph_t *const *graphs;
+    size_t count;
+    const copper_options_t *options;
+    copper_result_t *results;
+    // The next graph to hand out
+    size_t next;
+    pthread_mutex_t mut;
+} batch_t;
+
+static void *batch_worker(void *batch_void) {
+    batch_t *batch = (batch_t *) batch_void;
+    copper_options_t unused;
+    engine_tuning_t tuning;
+    solver_ctx_t ctx;
+
+    setup(batch->options, &unused, &tuning, &ctx);
+    ctx.arena = arena_new(COPPER_ARENA_SIZE);
+
+    while (TRUE) {
+        pthread_mutex_lock(&batch->mut);
+        size_t i = batch->next++;
+        pthread_mutex_unlock(&batch->mut);
+
+        if (i >= batch->count) {
+            break;
+        }
+
+        copper_result_t *result = batch->results + i;
+        memset(result, 0, sizeof(copper_result_t));
+        if (NULL == batch->graphs[i]) {
+            result->status = COPPER_INVALID;
+            continue;
+        }
+
+        solve(batch->graphs[i], batch->options, &ctx, result);
+        arena_trim(ctx.arena, COPPER_ARENA_KEEP);
+    }
+
+    arena_destroy(ctx.arena);
+
+    return NULL;
+}
+
+copper_status_t copper_batch(copper_graph_t *const *graphs, size_t count, const copper_options_t *options,
+                             copper_result_t *results) {
+    copper_options_t defaults;
+    engine_tuning_t tuning;
+    solver_ctx_t ctx;
+
+    if (NULL == graphs || NULL == results || NULL == (options = setup(options, &defaults, &tuning, &ctx))) {
+        return COPPER_INVALID;
+    }
+
+    // Until solved; a graph no thread gets to keeps it
+    for (size_t i = 0; i < count; ++i) {
+        memset(results + i, 0, sizeof(copper_result_t));
+        results[i].status = COPPER_NO_RESOURCES;
+    }
+
+    batch_t batch;
+    batch.graphs = graphs;
+    batch.count = count;
+    batch.options = options;
+    batch.results = results;
+    batch.next = 0;
+    pthread_mutex_init(&batch.mut, NULL);
+
+    size_t workers = options->workers > 0 ? options->workers : 1;
+    if (workers > count) {
+        workers = count;
+    }
+
+    copper_status_t status = COPPER_OK;
+    if (workers <= 1) {
+        batch_worker(&batch);
+    } else {
+        pthread_t *threads = malloc(sizeof(pthread_t) * workers);
+        if (NULL == threads) {
+            pthread_mutex_destroy(&batch.mut);
+            return COPPER_NO_RESOURCES;
+        }
+
+        size_t started = 0;
+        while (started < workers && 0 == pthread_create(threads + started, NULL, batch_worker, &batch)) {
+            started++;
+        }
+        if (started < workers) {
+            // Not run as asked: hand out no more graphs, and let the threads that did start finish theirs
+            pthread_mutex_lock(&batch.mut);
+            batch.next = count;
+            pthread_mutex_unlock(&batch.mut);
+            status = COPPER_NO_RESOURCES;
+        }
+
+        for (size_t w = 0; w < started; ++w) {
+            pthread_join(threads[w], NULL);
+        }
+        free(threads);
+    }
+
+    pthread_mutex_destroy(&batch.mut);
+
+    return status;
+}
@@ -0,0 +1,156 @@
+#ifndef COPPER_H
+#define COPPER_H
+
+/*
+ * libcopper: compute cop numbers from another program, without the Copper executable.
+ *
+ * This header is the interface of the library: it only uses standard types. The options
+ * are allocated by the caller, so their layout is versioned: copper_options_default stamps
+ * them with COPPER_API_VERSION, and options of another version are rejected as invalid
+ * rather than misread. Nothing is printed; every call reports through its return value
+ * and its result structure.
+ */
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Bumped whenever a structure of this header changes, fields added at the end included
+#define COPPER_API_VERSION 2
+
+/**
+ * A graph, ready to be solved. Graphs are reflexive: every vertex is in its own
+ * closed neighbourhood. A graph may be solved by several threads at once.
+ */
+typedef struct copper_graph copper_graph_t;
+
+/**
+ * How a cop number computation went
+ */
+typedef enum {
+    // The cop number was found
+    COPPER_OK = 0,
+    // The cop number is over the maximum k asked for
+    COPPER_OVER,
+    // A run at some k was too large to represent or allocate
+    COPPER_REFUSED,
+    // The arguments were invalid (null graph, unknown engine, ...)
+    COPPER_INVALID,
+    // A budget ran out before the cop number was found
+    COPPER_TIMEOUT,
+    // A batch could not get the threads or the memory to run with (see copper_batch)
+    COPPER_NO_RESOURCES
+} copper_status_t;
+
+/**
+ * What to compute, and how
+ */
+typedef struct {
+    // COPPER_API_VERSION, set by copper_options_default
+    unsigned int version;
+    // The maximum number of cops to try
+    unsigned int max_k;
+    // The engine running the fixed point, by name (see Copper -h); null for automatic
+    const char *engine;
+    // Memory, in bytes, a single run may take before a leaner engine is picked
+    size_t resident_budget;
+    // Directory for out-of-core storage (null to always stay in memory)
+    const char *scratch_dir;
+    // Threads copper_batch may use (1 to stay on the calling thread)
+    unsigned int workers;
+    // The order of the fixed point's worklist, by name (see Copper -h); null for automatic
+    const char *worklist;
+    // Budgets of each graph (0 for none): wall time, in seconds, and worklist pops
+    double time_budget;
+    unsigned long long pop_budget;
+    // Non-zero to drop the robber positions dominated by another from the fixed point (same answer)
+    int dominance;
+    // Threads each run may split its matrix products across (the m4rm engine), on top of workers
+    unsigned int run_threads;
+} copper_options_t;
+
+/**
+ * The answer for one graph, and how it was obtained
+ */
+typedef struct {
+    copper_status_t status;
+    // The cop number if COPPER_OK, the k the budget ran out at if COPPER_TIMEOUT, max_k + 1 otherwise
+    unsigned int cop_number;
+    // What decided the cop number: "fixed-point" or the name of a bound
+    const char *decided_by;
+    // The number of times the fixed point ran (bounds settle some k without it)
+    unsigned int fixed_point_runs;
+    // Wall time spent on the graph, in seconds
+    double seconds;
+    // The positions the fixed point runs popped from their worklists
+    unsigned long long worklist_pops;
+} copper_result_t;
+
+/**
+ * Fill the options with the defaults, for this version of the interface: max_k of 4, automatic engine and worklist, 1 GB per run as
+ * for the Copper executable, in memory, one worker, no budgets, no pruning
+ * @param options the options
+ */
+void copper_options_default(copper_options_t *options);
+
+/**
+ * Build a graph from its adjacency matrix
+ * @param n the number of vertices
+ * @param adjacency n * n bytes, row by row; non-zero for an edge. Only the part above
+ * the diagonal is read, so the matrix need not be symmetric.
+ * @return the graph, or null if allocation failed
+ */
+copper_graph_t *copper_graph_from_adjacency(unsigned int n, const unsigned char *adjacency);
+
+/**
+ * Build a graph from its graph6 encoding
+ * @param g6 the encoding (a trailing newline is allowed; no ">>graph6<<" header)
+ * @param len the length of the encoding, in bytes
+ * @return the graph, or null if the encoding is invalid or allocation failed
+ */
+copper_graph_t *copper_graph_from_g6(const char *g6, size_t len);
+
+/**
+ * The number of vertices of a graph
+ * @param g the graph
+ * @return n
+ */
+unsigned int copper_graph_order(const copper_graph_t *g);
+
+/**
+ * Free a graph
+ * @param g the graph (may be null)
+ */
+void copper_graph_destroy(copper_graph_t *g);
+
+/**
+ * Compute the cop number of a graph, on the calling thread
+ * @param g the graph
+ * @param options the options (null for the defaults)
+ * @param result the answer
+ * @return result->status
+ */
+copper_status_t copper_cop_number(const copper_graph_t *g, const copper_options_t *options,
+                                  copper_result_t *result);
+
+/**
+ * Compute the cop numbers of many graphs, on options->workers threads. Each thread
+ * keeps its working memory from one graph to the next.
+ * @param graphs the graphs
+ * @param count the number of graphs
+ * @param options the options (null for the defaults)
+ * @param results count answers, in the order of the graphs
+ * @return COPPER_INVALID if the arguments were, COPPER_NO_RESOURCES if a thread could not
+ * be created (the graphs left unsolved are then COPPER_NO_RESOURCES), COPPER_OK otherwise
+ * (see each result)
+ */
+copper_status_t copper_batch(copper_graph_t *const *graphs, size_t count, const copper_options_t *options,
+                             copper_result_t *results);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //COPPER_H
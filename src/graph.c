@@ -1,5 +1,6 @@
 #include "graph.h"
 #include "bitset.h"
+#include <string.h>
 
 /**
  * Compute the integer power
@@ -7,10 +8,10 @@
  * https://stackoverflow.com/a/101613/5092307
  * @param a the number to compute a power of
  * @param e the exponent to put the number too
- * @return a^e (int)
+ * @return a^e (int), modulo 2^64
  */
-u32 ipow(u32 a, u32 e) {
-    u32 r = 1;
+u64 ipow(u64 a, u32 e) {
+    u64 r = 1;
 
     while (1) {
         // odd?
@@ -29,21 +30,30 @@ u32 ipow(u32 a, u32 e) {
     return r;
 }
 
-u32 *int_to_tuple(size_t k, u32 *tuple, size_t n, u32 r) {
-    for (size_t i = 0; i < k; ++i) {
-        if (r > 0) {
-            u32 d = ipow(n, (k - i - 1));
-            tuple[i] = r / d;
-            r -= tuple[i] * d;
-        } else {
-            tuple[i] = 0;
+bool ipow_checked(u64 a, u32 e, u64 *r) {
+    u64 p = 1;
+
+    for (u32 i = 0; i < e; ++i) {
+        if (__builtin_mul_overflow(p, a, &p)) {
+            return FALSE;
         }
     }
 
+    *r = p;
+    return TRUE;
+}
+
+u32 *int_to_tuple(size_t k, u32 *tuple, size_t n, u64 r) {
+    // Least significant coordinate first: one division each, and no powers of n
+    for (size_t i = k; i > 0; --i) {
+        tuple[i - 1] = r % n;
+        r /= n;
+    }
+
     return tuple;
 }
 
-i8 edge_get_and_set(graph_t *g, u32 from, u32 to, i8 new) {
+i8 edge_get_and_set(graph_t *g, u64 from, u64 to, i8 new) {
 
     if (NULL == g) {
         return -1;
@@ -64,6 +74,15 @@ i8 edge_get_and_set(graph_t *g, u32 from, u32 to, i8 new) {
         bitset_t *b = rows[to];
         bitset_set(a, to, new);
         bitset_set(b, from, new);
+
+        if (NULL != g->adj_start) {
+            // The lists no longer match the rows
+            mem_free(g->arena, g->adj);
+            mem_free(g->arena, g->adj_start);
+            g->adj_start = NULL;
+            g->adj = NULL;
+            g->sparse = FALSE;
+        }
     }
 
     return old;
@@ -77,31 +96,38 @@ i8 edge_get_and_set(graph_t *g, u32 from, u32 to, i8 new) {
  * @return the graph (or null, if allocation failed)
  */
 graph_t *new_graph(size_t nb_vertices, bool reflexive) {
-    graph_t *g = (graph_t *) malloc(sizeof(graph_t));
+    return new_graph_in(NULL, nb_vertices, reflexive);
+}
+
+graph_t *new_graph_in(arena_t *arena, size_t nb_vertices, bool reflexive) {
+    graph_t *g = (graph_t *) mem_alloc(arena, sizeof(graph_t));
 
     if (!g) {
         return NULL;
     }
 
     g->n = nb_vertices;
-    g->rows = malloc(sizeof(bitset_t *) * nb_vertices);
+    g->arena = arena;
+    g->adj_start = NULL;
+    g->adj = NULL;
+    g->sparse = FALSE;
+    g->rows = mem_alloc_array(arena, nb_vertices, sizeof(bitset_t *));
 
     if (!g->rows) {
-        free(g);
+        mem_free(arena, g);
         return NULL;
     }
 
     // Clear to null so we can deallocate properly if it fails
-    for (u32 i = 0; i < nb_vertices; ++i) {
+    for (size_t i = 0; i < nb_vertices; ++i) {
         g->rows[i] = NULL;
     }
 
-    for (u32 i = 0; i < nb_vertices; ++i) {
-        if (NULL == (g->rows[i] = new_bitset(nb_vertices))) {
+    for (size_t i = 0; i < nb_vertices; ++i) {
+        // New bitsets are cleared already
+        if (NULL == (g->rows[i] = new_bitset_in(arena, nb_vertices))) {
             // Cleanup
             return destroy_graph(g);
-        } else {
-            bitset_all(g->rows[i], FALSE);
         }
     }
 
@@ -119,67 +145,141 @@ graph_t *new_graph(size_t nb_vertices, bool reflexive) {
  * Free the graph's memory @param g the graph
  */
 graph_t *destroy_graph(graph_t *g) {
-    for (u32 i = 0; i < g->n; ++i) {
+    if (NULL != g->arena) {
+        // Reclaimed with the arena
+        return NULL;
+    }
+
+    for (size_t i = 0; i < g->n; ++i) {
         if (NULL != g->rows[i]) {
             bitset_destroy(g->rows[i]);
         }
     }
     free(g->rows);
+    free(g->adj_start);
+    free(g->adj);
     free(g);
     return NULL;
 }
 
-bitset_t *neighbourhood(graph_t *g, const u32 *S, size_t width) {
-    bitset_t *b = new_bitset(g->n);
-
-    if (!b) { return b; }
-
-    for (u32 i = 0; i < width; ++i) {
-        bitset_or(b, g->rows[S[i]]);
+bool graph_index(graph_t *g) {
+    size_t n = g->n;
+    u64 total = graph_lists_in(g->arena, g, &g->adj_start, &g->adj);
+    if (NULL == g->adj_start || NULL == g->adj) {
+        mem_free(g->arena, g->adj);
+        mem_free(g->arena, g->adj_start);
+        g->adj_start = NULL;
+        g->adj = NULL;
+        return FALSE;
     }
 
-    return b;
+    g->sparse = total * GRAPH_SPARSE_RATIO <= (u64) n * (n / BITSET_WIDTH + (n % BITSET_WIDTH > 0));
+    return TRUE;
 }
 
-graph_t *tensor_power(graph_t *g, u32 s) {
+u64 graph_lists_in(arena_t *arena, graph_t *g, u64 **adj_start, u32 **adj) {
     size_t n = g->n;
-    size_t N = (size_t) ipow(n, s);
+    u64 *start = mem_alloc(arena, sizeof(u64) * (n + 1));
+    u64 total = 0;
+
+    if (NULL != g->adj_start) {
+        total = g->adj_start[n];
+    } else {
+        for (size_t v = 0; v < n; ++v) {
+            total += bitset_count(g->rows[v]);
+        }
+    }
+    u32 *lists = mem_alloc_array(arena, total, sizeof(u32));
+
+    if (NULL != start && NULL != lists) {
+        if (NULL != g->adj_start) {
+            memcpy(start, g->adj_start, sizeof(u64) * (n + 1));
+            memcpy(lists, g->adj, sizeof(u32) * total);
+        } else {
+            start[0] = 0;
+            for (size_t v = 0; v < n; ++v) {
+                start[v + 1] = start[v] + bitset_indices_into(g->rows[v], lists + start[v]);
+            }
+        }
+    }
 
-    graph_t *tensor_graph = new_graph(N, TRUE);
+    *adj_start = start;
+    *adj = lists;
+    return total;
+}
 
-    if (!tensor_graph) { return tensor_graph; }
+bitset_t *neighbourhood(graph_t *g, const u32 *S, size_t width) {
+    bitset_t *b = new_bitset(g->n);
 
-    u32 *cached_a, *cached_b;
-    cached_a = (u32 *) malloc(sizeof(u32) * s);
-    cached_b = (u32 *) malloc(sizeof(u32) * s);
+    if (!b) { return b; }
 
-    for (u32 i = 0; i < N; ++i) {
-        for (u32 j = i; j < N; ++j) {
-            // We get a potential edge (i,j);
+    return neighbourhood_into(g, S, width, b);
+}
 
-            bool edge = 1;
-            if (i != j) {
-                // Both i and j are encoded tuples. We name their tuples a, b respectively
-                u32 *a = int_to_tuple(s, cached_a, n, i);
-                u32 *b = int_to_tuple(s, cached_b, n, j);
+bitset_t *neighbourhood_into(graph_t *g, const u32 *S, size_t width, bitset_t *b) {
+    u32 l = b->l;
+    BITSET_DATA_UNIT *out = b->parts;
 
-                // There is an edge between a bitset b iif all the respective components are adjacent
-                for (u32 c = 0; c < s && edge; ++c) {
-                    edge = edge_get_and_set(g, a[c], b[c], READ_ONLY);
-                }
-            }
+    for (u32 w = 0; w < l; ++w) {
+        out[w] = 0;
+    }
 
-            edge_get_and_set(tensor_graph, i, j, edge);
+    if (g->sparse) {
+        // A few bits per vertex rather than a whole row
+        const u64 *adj_start = g->adj_start;
+        const u32 *adj = g->adj;
+        for (u32 i = 0; i < width; ++i) {
+            for (u64 a = adj_start[S[i]]; a < adj_start[S[i] + 1]; ++a) {
+                out[adj[a] / BITSET_WIDTH] |= 1U << (adj[a] % BITSET_WIDTH);
+            }
         }
+        return b;
     }
 
-    // Get rid of the tuples
-    free(cached_a);
-    free(cached_b);
+    for (u32 i = 0; i < width; ++i) {
+        BITSET_DATA_UNIT *row = g->rows[S[i]]->parts;
+        for (u32 w = 0; w < l; ++w) {
+            out[w] |= row[w];
+        }
+    }
 
-    return tensor_graph;
+    return b;
 }
 
+u64 tensor_neighbours_into(graph_t *g, u32 s, const u32 *tuple, u32 *out) {
+    size_t n = g->n;
+    u64 *adj_start = g->adj_start;
+    u32 *adj = g->adj;
+
+    // Two positions are adjacent iff all their respective coordinates are: an odometer over
+    // the coordinates' closed neighbourhoods, re-encoding only the coordinates that moved
+    u64 pos[s], weight[s], partial[s + 1];
+    partial[0] = 0;
+    for (u32 c = 0; c < s; ++c) {
+        weight[c] = ipow(n, s - c - 1);
+        pos[c] = adj_start[tuple[c]];
+        partial[c + 1] = partial[c] + adj[pos[c]] * weight[c];
+    }
+
+    u64 count = 0;
+    while (TRUE) {
+        out[count++] = partial[s];
+
+        i32 c = (i32) s - 1;
+        while (c >= 0 && ++pos[c] == adj_start[tuple[c] + 1]) {
+            pos[c] = adj_start[tuple[c]];
+            c--;
+        }
+        if (c < 0) {
+            break;
+        }
+        for (; c < (i32) s; ++c) {
+            partial[c + 1] = partial[c] + adj[pos[c]] * weight[c];
+        }
+    }
+
+    return count;
+}
 
 bool graph_has_pitfall(graph_t *g, u8 k) {
 
@@ -194,12 +294,15 @@ bool graph_has_pitfall(graph_t *g, u8 k) {
         // the neighbour sets.
         bitset_t *covered = new_bitset(g->rows[u]->bits);
 
-        u32 loops = ipow(neigh_sz, k);
+        u64 loops = ipow(neigh_sz, k);
+        // Every k-tuple of neighbours, walked with an odometer
+        for (u32 j = 0; j < k; ++j) {
+            indices_set[j] = 0;
+        }
 
-        for (u32 i = 0; i < loops; ++i) {
+        for (u64 i = 0; i < loops; ++i) {
             bitset_t *n = bitset_clone(g->rows[u]);
             bitset_all(covered, 0);
-            int_to_tuple(k, indices_set, neigh_sz, i);
 
             for (u32 j = 0; j < k; ++j) {
                 u32 neigh_index = indices_set[j];
@@ -221,6 +324,11 @@ bool graph_has_pitfall(graph_t *g, u8 k) {
             if (has_pit) {
                 break;
             }
+
+            i32 j = (i32) k - 1;
+            while (j >= 0 && ++indices_set[j] == neigh_sz) {
+                indices_set[j--] = 0;
+            }
         }
 
         bitset_destroy(covered);
@@ -8,12 +8,41 @@
 #define READ_ONLY (-1)
 #define EDGE 1
 #define NO_EDGE 0
+// Setting a bit from a list costs about this many blocks of a row ORed: past it, the
+// rows are cheaper (measured on cubic graphs, where the lists win from n = 1500 or so)
+#define GRAPH_SPARSE_RATIO 10
 
 typedef struct {
     bitset_t **rows;
     size_t n;
+    // Where the graph was allocated from (null for the heap)
+    arena_t *arena;
+    // The closed neighbourhoods as sorted lists (compressed sparse rows), null until
+    // graph_index builds them: N[v] is adj[adj_start[v] .. adj_start[v + 1])
+    u64 *adj_start;
+    u32 *adj;
+    // Set by graph_index: the lists are cheaper to walk than the rows are to OR
+    bool sparse;
 } graph_t;
 
+/**
+ * Compute the integer power
+ * @param a the number to compute a power of
+ * @param e the exponent to put the number too
+ * @return a^e (int), modulo 2^64
+ */
+u64 ipow(u64 a, u32 e);
+
+/**
+ * Compute the integer power, checking for overflow. This is how the number of
+ * positions n^k of a run is computed.
+ * @param a the number to compute a power of
+ * @param e the exponent to put the number too
+ * @param r where to store a^e
+ * @return if a^e fits in 64 bits (r is untouched otherwise)
+ */
+bool ipow_checked(u64 a, u32 e, u64 *r);
+
 /**
  * Convert an integer to a tuple of integers. This is used to convert from a vertex from a tensor graph
  * to set a vertices into the original graph.
@@ -23,18 +52,19 @@ typedef struct {
  * @param r the integer
  * @return a k-wide array of integers (max value n), heap-allocated, possibly NULL
  */
-u32 *int_to_tuple(size_t k, u32 *tuple, size_t n, u32 r);
+u32 *int_to_tuple(size_t k, u32 *tuple, size_t n, u64 r);
 
 /**
  * Given a graph, get the edge from a vertex to another bitset_and bitset_set the value.
- * If the new value is -1, nothing is changed
+ * If the new value is -1, nothing is changed. Changing an edge drops the lists of
+ * graph_index.
  * @param g the graph
  * @param from the first vertice (0 index)
  * @param to the second vertice (0 index)
  * @param new the new value (0 for no edge, 1 for an edge, -1 for read only)
  * @return an error code if there is an error, or 0 bitset_or 1 depending on wether there is an edge
  */
-i8 edge_get_and_set(graph_t *g, u32 from, u32 to, i8 new);
+i8 edge_get_and_set(graph_t *g, u64 from, u64 to, i8 new);
 
 /**
  * Allocate a graph
@@ -45,11 +75,43 @@ i8 edge_get_and_set(graph_t *g, u32 from, u32 to, i8 new);
  */
 graph_t *new_graph(size_t nb_vertices, bool reflexive);
 
+/**
+ * Allocate a graph from an arena (or the heap if the arena is null). Destroying
+ * a graph from an arena does nothing; its memory goes away with the arena's reset.
+ * @param arena the arena
+ * @param nb_vertices the number of vertices in the graph
+ * @param reflexive if the graph is going to be reflexive
+ * @return the graph (or null, if allocation failed)
+ */
+graph_t *new_graph_in(arena_t *arena, size_t nb_vertices, bool reflexive);
+
 /**
  * Free the graph's memory @param g the graph
  */
 graph_t *destroy_graph(graph_t *g);
 
+/**
+ * Build the closed neighbourhoods of a graph as lists, once its edges are set, and
+ * pick the representation its neighbourhoods are computed with: the lists when the
+ * graph is sparse, that is when its closed neighbourhoods are GRAPH_SPARSE_RATIO times
+ * shorter on average than a row is in blocks, the rows otherwise. Graphs whose lists are
+ * not built use the rows.
+ * @param g the graph
+ * @return if the lists were built (they are not if allocation failed)
+ */
+bool graph_index(graph_t *g);
+
+/**
+ * Copy the closed neighbourhoods of a graph as lists, from the ones of graph_index if
+ * they were built, from the rows otherwise
+ * @param arena where to allocate the lists from (may be null)
+ * @param g the graph
+ * @param adj_start where to store the n + 1 starts of the lists
+ * @param adj where to store the lists
+ * @return the total length of the lists
+ */
+u64 graph_lists_in(arena_t *arena, graph_t *g, u64 **adj_start, u32 **adj);
+
 /**
  * For a subset of vertices S, creates a bitset that represents all the vertices that are a
  * neighbour of any vertex in S
@@ -63,12 +125,27 @@ graph_t *destroy_graph(graph_t *g);
 bitset_t *neighbourhood(graph_t *g, const u32 *T, size_t width);
 
 /**
- * Create a graph at the desired tensor power
+ * Same as neighbourhood, into an existing bitset of g->n bits
  * @param g the graph
- * @param s the tensor power to apply to the graph
- * @return the new graph (or null if memory allocation failed)
+ * @param S the set of vertices
+ * @param width the size of S
+ * @param b the bitset to fill
+ * @return b
+ */
+bitset_t *neighbourhood_into(graph_t *g, const u32 *S, size_t width, bitset_t *b);
+
+/**
+ * The neighbours of a position of a tensor power, from the lists of the graph rather
+ * than from the tensor graph: the product of the closed neighbourhoods of its
+ * coordinates. Costs the number of neighbours, where a row of the tensor graph takes n^s bits.
+ * @param g the graph, with its lists (see graph_index, or graph_lists_in into a copy)
+ * @param s the tensor power
+ * @param tuple the coordinates of the position
+ * @param out where to write the neighbours, in increasing order: as many as the product
+ * of the closed degrees of the coordinates
+ * @return the number of neighbours
  */
-graph_t *tensor_power(graph_t *g, u32 s);
+u64 tensor_neighbours_into(graph_t *g, u32 s, const u32 *tuple, u32 *out);
 
 /**
  * Verify if the graph has a pitfall of at most k dominators
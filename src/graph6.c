@@ -11,34 +11,64 @@
  * Get the graph size from a g6 string graph, where
  * all bytes have been -63
  * @param data_string the data string
- * @return the len of the graph
+ * @return the len of the graph (up to 2^36 - 1)
  */
-u32 g6_len(u8 *data_string, size_t *start) {
+u64 g6_len(u8 *data_string, size_t *start) {
     if (data_string[0] <= 62) {
         *start = 1;
         return data_string[0];
     } else if (data_string[1] <= 62) {
         *start = 4;
-        return (data_string[1] << 12) + (data_string[2] << 6) + data_string[3];
+        return ((u64) data_string[1] << 12) + ((u64) data_string[2] << 6) + data_string[3];
     } else {
         *start = 8;
-        return (data_string[2] << 30) +
-               (data_string[3] << 24) +
-               (data_string[4] << 18) +
-               (data_string[5] << 12) +
-               (data_string[6] << 6) +
+        return ((u64) data_string[2] << 30) +
+               ((u64) data_string[3] << 24) +
+               ((u64) data_string[4] << 18) +
+               ((u64) data_string[5] << 12) +
+               ((u64) data_string[6] << 6) +
                data_string[7];
     }
 }
 
+void g6_shape(const char *raw_data, u64 *n, u64 *edges) {
+    // The longest header, as g6_len wants it
+    u8 header[8];
+    size_t len = 0;
+    while (len < 8 && '\0' != raw_data[len] && '\n' != raw_data[len] && '\r' != raw_data[len]) {
+        header[len] = (u8) raw_data[len] - 63U;
+        len++;
+    }
+
+    *n = 0;
+    *edges = 0;
+    size_t start = 0;
+    if (0 == len || (header[0] > 62 && len < 4) || (header[0] > 62 && header[1] > 62 && len < 8)) {
+        return;
+    }
+    *n = g6_len(header, &start);
+
+    for (const char *c = raw_data + start; '\0' != *c && '\n' != *c && '\r' != *c; ++c) {
+        *edges += __builtin_popcount(((u8) *c - 63U) & 63U);
+    }
+}
+
 /**
  *
  * @param raw_data
  * @return
  */
 graph_t *from_g6(char *raw_data) {
+    return from_g6_in(NULL, raw_data);
+}
+
+graph_t *from_g6_in(arena_t *arena, char *raw_data) {
     size_t bytes = strlen(raw_data);
-    u8 *_raw_data = (u8 *) malloc(sizeof(char) * bytes);
+    // The line terminator is not part of the graph
+    while (bytes > 0 && ('\n' == raw_data[bytes - 1] || '\r' == raw_data[bytes - 1])) {
+        bytes--;
+    }
+    u8 *_raw_data = (u8 *) mem_alloc(arena, sizeof(char) * bytes);
     memcpy(_raw_data, raw_data, bytes);
 
     for (size_t b = 0; b < bytes; ++b) {
@@ -46,18 +76,41 @@ graph_t *from_g6(char *raw_data) {
     }
 
     size_t start = 0;
-    u32 n = g6_len(_raw_data, &start);
+    u64 n = g6_len(_raw_data, &start);
 
-    bitset_t *edge_bits = new_bitset(((n * (n - 1)) / 2));
+    // Vertices are u32 everywhere; past that, the adjacency matrix alone would not fit anyway
+    if (n > G6_MAX_VERTICES) {
+        mem_free(arena, _raw_data);
+        return NULL;
+    }
 
-    u32 cursor = 0;
-    for (uint scout = start; scout < bytes; ++scout) {
-        for (i8 rank = 5; rank >= 0; --rank) {
-            bitset_set(edge_bits, cursor++, (_raw_data[scout] >> rank) & 1U);
+    u64 edge_count = (n * (n - 1)) / 2;
+    bitset_t *edge_bits = new_bitset_in(arena, edge_count);
+    graph_t *g = new_graph_in(arena, n, 1);
+
+    if (NULL == edge_bits || NULL == g) {
+        if (NULL == arena) {
+            bitset_destroy(edge_bits);
+            if (NULL != g) {
+                destroy_graph(g);
+            }
+            free(_raw_data);
         }
+        return NULL;
+    }
+
+    // Only read the bytes that hold edges, the rest is padding we cannot store
+    u64 needed = start + (edge_count + 5) / 6;
+    if (bytes > needed) {
+        bytes = needed;
     }
 
-    graph_t *g = new_graph(n, 1);
+    u64 cursor = 0;
+    for (size_t scout = start; scout < bytes; ++scout) {
+        for (i8 rank = 5; rank >= 0 && cursor < edge_count; --rank) {
+            bitset_set(edge_bits, cursor++, (_raw_data[scout] >> rank) & 1U);
+        }
+    }
 
     cursor = 0;
     for (u32 j = 1; j < n; ++j) {
@@ -66,8 +119,13 @@ graph_t *from_g6(char *raw_data) {
         }
     }
 
-    bitset_destroy(edge_bits);
-    free(_raw_data);
+    if (NULL == arena) {
+        bitset_destroy(edge_bits);
+        free(_raw_data);
+    }
+
+    // Without the lists, the rows do
+    graph_index(g);
 
     return g;
 }
@@ -7,6 +7,8 @@
 
 #define G6_HEADER ">>graph6<<"
 #define G6_HEADER_LEN 10
+// The largest graph decoded: vertices are numbered with u32
+#define G6_MAX_VERTICES 0xFFFFFFFFULL
 
 #include <stdlib.h>
 #include "types.h"
@@ -16,9 +18,18 @@
  * Get the graph size from a g6 string graph, where
  * all bytes have been -63
  * @param data_string the data string
- * @return the len of the graph
+ * @return the len of the graph (up to 2^36 - 1)
  */
-u32 g6_len(u8 *data_string, size_t *start);
+u64 g6_len(u8 *data_string, size_t *start);
+
+/**
+ * Read the size of a g6 graph without decoding it: its number of vertices from the
+ * header, and its number of edges from the bits set in the rest
+ * @param raw_data the g6 line
+ * @param n the number of vertices (0 if the line is too short to hold a header)
+ * @param edges the number of edges
+ */
+void g6_shape(const char *raw_data, u64 *n, u64 *edges);
 
 /**
  *
@@ -27,4 +38,12 @@ u32 g6_len(u8 *data_string, size_t *start);
  */
 graph_t *from_g6(char *raw_data);
 
+/**
+ * Decode a g6 graph into an arena (or the heap if the arena is null)
+ * @param arena the arena
+ * @param raw_data the g6 line
+ * @return the graph, or null if it is too large to be decoded
+ */
+graph_t *from_g6_in(arena_t *arena, char *raw_data);
+
 #endif //COPNV2_GRAPH6_H
@@ -0,0 +1,134 @@
+#include "line_ring.h"
+
+void line_ring_init(line_ring_t *r, u32 cap, bool by_cost) {
+    pthread_mutex_init(&r->mut, NULL);
+    pthread_cond_init(&r->published, NULL);
+    pthread_cond_init(&r->released, NULL);
+
+    r->slots = calloc(cap, sizeof(line_slot_t));
+    r->ready = malloc(sizeof(line_slot_t *) * cap);
+    r->free = malloc(sizeof(line_slot_t *) * cap);
+    r->ready_lo = 0;
+    r->ready_sz = 0;
+    r->by_cost = by_cost;
+    r->cap = cap;
+    r->closed = FALSE;
+
+    for (u32 i = 0; i < cap; ++i) {
+        r->free[i] = r->slots + i;
+    }
+    r->free_sz = cap;
+}
+
+void line_ring_destroy(line_ring_t *r) {
+    for (u32 i = 0; i < r->cap; ++i) {
+        free(r->slots[i].line);
+    }
+    free(r->slots);
+    free(r->ready);
+    free(r->free);
+
+    pthread_mutex_destroy(&r->mut);
+    pthread_cond_destroy(&r->published);
+    pthread_cond_destroy(&r->released);
+}
+
+line_slot_t *line_ring_acquire(line_ring_t *r) {
+    pthread_mutex_lock(&r->mut);
+    while (0 == r->free_sz) {
+        pthread_cond_wait(&r->released, &r->mut);
+    }
+    line_slot_t *s = r->free[--r->free_sz];
+    pthread_mutex_unlock(&r->mut);
+
+    return s;
+}
+
+/**
+ * Add a published slot to the heap of ready slots, with the lock held
+ */
+static void heap_push(line_ring_t *r, line_slot_t *s) {
+    u32 i = r->ready_sz++;
+    while (i > 0 && r->ready[(i - 1) / 2]->cost < s->cost) {
+        r->ready[i] = r->ready[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    r->ready[i] = s;
+}
+
+/**
+ * Take the most expensive slot out of the heap of ready slots, with the lock held
+ */
+static line_slot_t *heap_pop(line_ring_t *r) {
+    line_slot_t *top = r->ready[0];
+    line_slot_t *last = r->ready[--r->ready_sz];
+
+    u32 i = 0;
+    while (2 * i + 1 < r->ready_sz) {
+        u32 child = 2 * i + 1;
+        if (child + 1 < r->ready_sz && r->ready[child + 1]->cost > r->ready[child]->cost) {
+            child++;
+        }
+        if (r->ready[child]->cost <= last->cost) {
+            break;
+        }
+        r->ready[i] = r->ready[child];
+        i = child;
+    }
+    r->ready[i] = last;
+
+    return top;
+}
+
+void line_ring_publish(line_ring_t *r, line_slot_t *s) {
+    pthread_mutex_lock(&r->mut);
+    // There are never more slots published than slots
+    if (r->by_cost) {
+        heap_push(r, s);
+    } else {
+        r->ready[(r->ready_lo + r->ready_sz++) % r->cap] = s;
+    }
+    pthread_cond_signal(&r->published);
+    pthread_mutex_unlock(&r->mut);
+}
+
+void line_ring_close(line_ring_t *r) {
+    pthread_mutex_lock(&r->mut);
+    r->closed = TRUE;
+    pthread_cond_broadcast(&r->published);
+    pthread_mutex_unlock(&r->mut);
+}
+
+line_slot_t *line_ring_take(line_ring_t *r) {
+    line_slot_t *s = NULL;
+
+    pthread_mutex_lock(&r->mut);
+    while (0 == r->ready_sz && !r->closed) {
+        pthread_cond_wait(&r->published, &r->mut);
+    }
+    if (r->ready_sz > 0 && r->by_cost) {
+        s = heap_pop(r);
+    } else if (r->ready_sz > 0) {
+        s = r->ready[r->ready_lo];
+        r->ready_lo = (r->ready_lo + 1) % r->cap;
+        r->ready_sz--;
+    }
+    pthread_mutex_unlock(&r->mut);
+
+    return s;
+}
+
+void line_ring_release(line_ring_t *r, line_slot_t *s) {
+    pthread_mutex_lock(&r->mut);
+    r->free[r->free_sz++] = s;
+    pthread_cond_signal(&r->released);
+    pthread_mutex_unlock(&r->mut);
+}
+
+bool line_ring_drained(line_ring_t *r) {
+    pthread_mutex_lock(&r->mut);
+    bool drained = r->closed && 0 == r->ready_sz;
+    pthread_mutex_unlock(&r->mut);
+
+    return drained;
+}
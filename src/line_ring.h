@@ -0,0 +1,106 @@
+#ifndef COPNV2_LINE_RING_H
+#define COPNV2_LINE_RING_H
+
+#include <stdlib.h>
+#include <pthread.h>
+#include "types.h"
+
+/**
+ * A line of the input, read ahead of the workers. The buffer belongs to the slot and
+ * is reused (getline grows it) from one line to the next.
+ */
+typedef struct {
+    char *line;
+    size_t cap;
+    // Where the graph starts in the line (past a header)
+    size_t skip;
+    // The graph's index in the file, and its rank among the graphs of this shard
+    u64 index;
+    u64 seq;
+    // The estimated cost of the graph, when the most expensive lines are taken first
+    u64 cost;
+} line_slot_t;
+
+/**
+ * A bounded ring of lines between the reader and the workers. The reader fills free
+ * slots and publishes them in input order; workers take them, decode the graph and
+ * hand the slot back. The reader waits when every slot is in use, so it never runs
+ * more than the ring's capacity ahead. The lock is only held to move slots around,
+ * never while reading or decoding.
+ * Lines are taken in input order, or by decreasing cost (a heap) so that the longest
+ * graphs of the lines read ahead start first.
+ */
+typedef struct {
+    pthread_mutex_t mut;
+    pthread_cond_t published;
+    pthread_cond_t released;
+    line_slot_t *slots;
+    // Published slots, a FIFO
+    line_slot_t **ready;
+    u32 ready_lo, ready_sz;
+    // Take the most expensive published line instead of the oldest
+    bool by_cost;
+    // Slots no one uses, a stack
+    line_slot_t **free;
+    u32 free_sz;
+    u32 cap;
+    bool closed;
+} line_ring_t;
+
+/**
+ * Initialize the ring
+ * @param r the structure
+ * @param cap the number of lines that may be read ahead
+ * @param by_cost if the most expensive published line is taken first (see line_slot_t.cost)
+ */
+void line_ring_init(line_ring_t *r, u32 cap, bool by_cost);
+
+/**
+ * Destroy the ring, and the buffers of its slots
+ * @param r the structure
+ */
+void line_ring_destroy(line_ring_t *r);
+
+/**
+ * Get a free slot to read a line into, waiting for one if needed (reader side)
+ * @param r the ring
+ * @return the slot
+ */
+line_slot_t *line_ring_acquire(line_ring_t *r);
+
+/**
+ * Hand a filled slot over to the workers (reader side)
+ * @param r the ring
+ * @param s the slot
+ */
+void line_ring_publish(line_ring_t *r, line_slot_t *s);
+
+/**
+ * Tell the workers no line will be published anymore (reader side)
+ * @param r the ring
+ */
+void line_ring_close(line_ring_t *r);
+
+/**
+ * Take the oldest published line (or the most expensive one), waiting for one if needed
+ * (worker side)
+ * @param r the ring
+ * @return the slot, or null once the ring is closed and every line was taken
+ */
+line_slot_t *line_ring_take(line_ring_t *r);
+
+/**
+ * Give a slot back once its line is not needed anymore (either side)
+ * @param r the ring
+ * @param s the slot
+ */
+void line_ring_release(line_ring_t *r, line_slot_t *s);
+
+/**
+ * Whether the ring is closed and every line was taken
+ * @param r the ring
+ * @return if no line will come out of the ring anymore
+ */
+bool line_ring_drained(line_ring_t *r);
+
+#endif //COPNV2_LINE_RING_H
@@ -5,370 +5,711 @@
 #include <dirent.h>
 #include <sys/stat.h>
 #include <pthread.h>
+#include <unistd.h>
 #include "bitset.h"
 #include "graph.h"
 #include "graph6.h"
-#include "vertice_queue.h"
+#include "solver.h"
+#include "bounds.h"
+#include "admission.h"
+#include "tuning.h"
+#include "calibrate.h"
+#include "merge.h"
+#include "line_ring.h"
+#include "trace.h"
+#include "progress.h"
 
 #define MAX_PATH_LENGTH 4096
+#define WORKER_ARENA_SIZE (1U << 20)
+#define DEFAULT_RESIDENT_MB 1024
+// What a worker's arena may keep between graphs, without a memory budget
+#define WORKER_ARENA_KEEP (64U << 20)
+// Lines the reader may get ahead of the workers, per worker
+#define PREFETCH_PER_WORKER 4
+// Per graph results a worker hands to the ordered output at once
+#define RESULT_BATCH 256
+// The output buffer, when stdout is not a terminal
+#define OUTPUT_BUFFER (1U << 20)
 
 typedef struct {
     bool aggregate;
     i32 max_cop;
     u8 workers;
+    FILE *certificates;
+    bool bounds_report;
+    char *scratch_dir;
+    size_t resident_budget;
+    // Memory budget shared by all the workers, 0 for none
+    size_t mem_budget;
+    engine_t engine;
+    engine_tuning_t *tuning;
+    worklist_policy_t worklist;
+    // Report the worklist pops of each graph (or their total, when aggregating)
+    bool pops_report;
+    // Prune the dominated robber positions from phi
+    bool dominance;
+    // Budgets of each graph (0 for none), and where to write the graphs that ran out
+    double time_budget;
+    u64 pop_budget;
+    FILE *retry;
+    // The spans of the workers, written out at exit (null for no tracing)
+    trace_t *trace;
+    // Seconds between progress lines on stderr, 0 for none
+    double progress;
+    // This process handles shard shard_index of shard_count of each file
+    u32 shard_index;
+    u32 shard_count;
+    // Shards are every shard_count-th graph instead of a range of bytes
+    bool shard_by_lines;
+    // Lines read ahead to start the most expensive graphs first, 0 for input order
+    u32 longest_first;
+    // Threads each run may use (the m4rm engine), 0 or 1 for the worker alone
+    u32 run_threads;
 } args_t;
 
-typedef struct {
-    u32 len;
-    u32 *list;
-} neigh_list_t;
-
 /**
- * Computes the following equation:
- * c(G) \leq k
- * This algorithm is based off the one given at
-    @article{bonato2010cops,
-      title={Cops and robbers from a distance},
-      author={Bonato, Anthony and Chiniforooshan, Ehsan and Pra{\l}at, Pawe{\l}},
-      journal={Theoretical Computer Science},
-      volume={411},
-      number={43},
-      pages={3834--3844},
-      year={2010},
-      publisher={Elsevier}
-    }
- * @param g the graph
- * @param k the cop number "target"
- * @return
+ * A graph a worker passed over because the memory it needs was not available.
+ * It is resumed at the k it stopped at once enough memory is released.
  */
-bool bonato_al_algo2(graph_t *g, u8 k) {
-
-    if (k >= 4) {
-        printf("%d, ", k);
-    }
-
-#ifdef USE_PITFALL_CHECK
-    if (1 == k && !graph_has_pitfall(g, 1)) {
-        return FALSE;
-    }
-#endif
+typedef struct deferred {
+    struct deferred *next;
+    char *line;
+    u64 index;
+    u64 seq;
+    u32 k;
+    size_t bytes;
+    // Popped by the runs before it was passed over
+    u64 pops;
+} deferred_t;
 
-    graph_t *tensor_graph = tensor_power(g, k);
+/**
+ * The result of a graph, waiting for the ones before it to be printed
+ */
+typedef struct {
+    u32 k;
+    bound_kind_t decided;
+    u64 pops;
+    // A budget ran out at k
+    bool timed_out;
+    bool ready;
+} result_t;
 
-    u32 n = g->n;
-    u32 N = tensor_graph->n;
+/**
+ * Print the usage message of the program
+ */
+void usage(bool quick) {
+    printf("Usage: [path_to_g6|-] [-h (help)] [-k cop_number] [-w no_workers=1] [-c] [-s] [-a] [-x certificate_file] [-b] [-o scratch_dir] [-r resident_mb] [--mem-budget mb] [--engine name] [--worklist name] [--pops] [--dominance] [--time-budget seconds] [--pop-budget pops] [--retry file] [--trace file] [--progress seconds] [--tuning file] [--calibrate file] [--shard i/m] [--shard-by bytes|lines] [--longest-first lines] [--run-threads n]\n");
+    printf("       merge [-a] [--shard-by bytes|lines] shard_outputs...\n\n");
 
-    bitset_t **phi = (bitset_t **) (malloc(sizeof(bitset_t *) * N));
+    if (!quick) {
+        printf("Copper is a tool to compute the cop number of graphs, stored in the g6 file format. The g6 file format\n");
+        printf("can contain a single or multiple graphs. Without a path, or with -, graphs are read from the standard input\n");
+        printf("(for instance, piped from geng). The tool supports the following commands:");
 
-    for (u32 i = 0; i < N; ++i) {
-        phi[i] = NULL;
-    }
+        const u8 params = 26;
+        char *usage_str[26] = {
+                "-k : the cop maximum cop number to check. Beyond this number, graphs will not be computed.",
+                "-w : the maximum number of workers to use in parallel. The program may decide to not use them all.",
+                "-c : if the computation must be timed using wall clock time (real time).",
+                "-s : silent mode, does not print a description of received parameters.",
+                "-a : aggregate mode, will not print the graph's cop number, but will print a table aggregating the result. Requires -k specified.",
+                "-x : write, for each graph, the cops' winning start position and capture strategy to the given file.",
+                "-b : report which argument decided each cop number (the fixed point or a cheap bound).",
+                "-o : out-of-core mode, graphs too large for memory keep their state in files in the given directory.",
+                "-r : the memory, in MB, a graph may take before going out of core, and then may keep resident (default 1024).",
+                "--mem-budget : the memory, in MB, all the workers may use together. Graphs that do not fit wait, while smaller ones go ahead. Each worker also keeps 1 MB of its own between graphs.",
+                "--engine : the engine running the fixed point: auto (default), materialized, sweep, out-of-core, word, delta, retrograde (backward induction on the game states, to cross-check the others) or m4rm (rounds over all the positions as Boolean matrix products, for dense graphs).",
+                "--worklist : the order of the materialized engine's worklist: auto (default), fifo, lifo, phi-size (smallest phi first), shrink (largest recent shrink first) or rounds (index ordered sweeps). Any but auto materializes the graphs that fit, and cannot be combined with another --engine.",
+                "--dominance : drop the robber positions dominated by another (a closed neighbourhood inside another's) from the fixed point. The answer is the same.",
+                "--pops : report the positions the fixed point popped from its worklist, per graph (or in total, when aggregating).",
+                "--time-budget : the wall time, in seconds, a graph may take. A graph that runs out is reported as \"timeout at k\" (or counted apart, when aggregating).",
+                "--pop-budget : the positions the fixed point may pop for a graph, as --time-budget but reproducible.",
+                "--retry : write the graphs that ran out of budget to the given file, to run them again separately.",
+                "--trace : record what each worker spends its time on (waiting for the lock or the input, decoding, building the tensor graph, the fixed point) and write it to the given file at exit, as a Chrome trace (chrome://tracing, Perfetto).",
+                "--progress : print the graphs done, the throughput, the input taken and the ETA on stderr every given number of seconds. SIGUSR1 prints them at any time, with the graph each worker is on.",
+                "--tuning : read the thresholds of the automatic engine selection from the given file.",
+                "--calibrate : measure the thresholds of the automatic engine selection on this host, write them to the given file and exit (this takes minutes).",
+                "--shard : only handle the i-th of m disjoint shards of the input (0 <= i < m), to split a run across processes.",
+                "--shard-by : shards are ranges of bytes aligned on lines (default), or every m-th graph.",
+                "--longest-first : read the given number of lines ahead and start the most expensive graphs first (by n, then sparsest first), so that no large graph is left to run alone at the end. Results still come out in input order.",
+                "--run-threads : the threads each run of the m4rm engine splits its matrix products across, on top of the -w workers (default 1).",
+                "merge : combine the outputs of the shards of a run (given in shard order), aggregate tables (-a) or per graph results."
+        };
 
-    // This is line 1 of the algorithm
-    // It sets the function to a bit mask of the neighbours in graph G
-    // There are n vertices in G; therefore the max size of a neighbourhood is n
-    // This is bitset_not very storage efficient as it is probably sparse.
-    u32 *cached_tuple = malloc(sizeof(u32) * k);
-    neigh_list_t *adjacency_list = malloc(sizeof(neigh_list_t) * N);
-    vertice_queue_t *q = vertice_queue_new(N);
+        for (u8 i = 0; i < params; ++i) {
+            printf("\t%s\n", usage_str[i]);
+        }
 
-    for (u32 i = 0; i < N; ++i) {
-        adjacency_list[i].len = 0; // We use len 0 as an indicator that it's empty since len >= 1 for all vertices
-        u32 *tuple = int_to_tuple(k, cached_tuple, n, i);
-        // This is convenient to preallocate the neighbourhoods anyways as we will bitset_not
-        // have to do more mallocs bitset_and free later
-        bitset_t *neigh = neighbourhood(g, tuple, k);
-        bitset_not(neigh, neigh);
-        phi[i] = neigh;
-        vertice_queue_push(q, i);
     }
+}
 
-    while (q->sz > 0) {
-        // Pop (line 4)
-        u32 T = vertice_queue_pop(q);
+typedef struct {
+    pthread_mutex_t *mut;
+    // The lines read ahead of the workers
+    line_ring_t *lines;
+    // Per graph results are printed in input order: the next one to print, and the
+    // ones that finished before it (a ring indexed by seq), protected by mut
+    u64 next_seq;
+    result_t *results;
+    u32 results_cap;
+    args_t *args;
+    // Graphs passed over for lack of memory, protected by mut
+    deferred_t *deferred;
+    admission_t *admission;
+} task_profile_t;
 
-        // Prepare the data for the rest of the while loop
-        bitset_t *phi_t = phi[T];
+/**
+ * A result a worker has not handed to the ordered output yet
+ */
+typedef struct {
+    u64 seq;
+    u32 k;
+    bound_kind_t decided;
+    u64 pops;
+    bool timed_out;
+} pending_t;
 
-        u32 phi_t_sz;
-        u32 *phi_t_vertex_set = bitset_indices(phi_t, &phi_t_sz);
-        bitset_t *phi_t_neighbourhood = neighbourhood(g, phi_t_vertex_set, phi_t_sz);
+/**
+ * What a worker collects on its own, so that finishing a graph takes no lock
+ */
+typedef struct {
+    task_profile_t *profile;
+    // Aggregate mode: this worker's share of the table (max_cop + 1 slots) and of
+    // the bounds report, summed once the workers are joined
+    u64 *breakdown;
+    u64 decided_by[BOUND_KINDS];
+    u64 pops;
+    // The graphs that ran out of budget, in a bucket of their own
+    u64 timeouts;
+    // Per graph mode: results waiting to be handed over, a batch at a time
+    pending_t pending[RESULT_BATCH];
+    u32 pending_sz;
+    // RESULT_BATCH, or 1 for a lone worker: nobody contends for the lock then, and
+    // its results stay in line with what the solver prints along the way
+    u32 batch;
+    // Where to record what the worker spends its time on (null for no tracing)
+    trace_buffer_t *trace;
+    // What the worker is doing, for the progress report (null if there is none)
+    progress_slot_t *progress;
+} worker_t;
 
-        neigh_list_t *nei = adjacency_list + T;
+/**
+ * Take the task lock, recording the wait
+ * @param profile the task profile
+ * @param trace the trace buffer of the thread (may be null)
+ */
+void task_lock(task_profile_t *profile, trace_buffer_t *trace) {
+    u64 start = trace_now(trace);
+    pthread_mutex_lock(profile->mut);
+    trace_span(trace, TRACE_LOCK, start, 0, 0);
+}
 
-        // Memoize
-        u32 neigh_sz;
-        u32 *neighbours_indices = NULL;
-        if (0 == nei->len) {
-            bitset_t *neigh_of_t = tensor_graph->rows[T];
-            neighbours_indices = bitset_indices(neigh_of_t, &neigh_sz);
-            nei->len = neigh_sz;
-            nei->list = neighbours_indices;
-        } else {
-            neigh_sz = nei->len;
-            neighbours_indices = nei->list;
+/**
+ * Record the result of a graph, and print all the results that are now in order,
+ * with the task lock held
+ * @param profile the task profile
+ * @param seq the rank of the graph
+ * @param k its cop number
+ * @param decided what decided it
+ * @param pops the positions its fixed point runs popped
+ * @param timed_out if a budget ran out (at k) instead
+ */
+void emit_result(task_profile_t *profile, u64 seq, u32 k, bound_kind_t decided, u64 pops, bool timed_out) {
+    if (seq - profile->next_seq >= profile->results_cap) {
+        // Too many graphs finished ahead of a slow one; make room, keeping positions by seq
+        u32 cap = profile->results_cap;
+        u32 new_cap = cap;
+        while (seq - profile->next_seq >= new_cap) {
+            new_cap *= 2;
         }
 
-        for (size_t i = 0; i < neigh_sz; ++i) {
-            u32 t_prime = neighbours_indices[i];
-            if (bitset_and(phi[t_prime], phi_t_neighbourhood)) {
-                vertice_queue_push(q, t_prime);
-            }
+        result_t *results = calloc(new_cap, sizeof(result_t));
+        for (u64 s = profile->next_seq; s != profile->next_seq + cap; ++s) {
+            results[s % new_cap] = profile->results[s % cap];
         }
-
-        // Cleanup
-        free(phi_t_vertex_set); // this was temporary
-//        free(neighbours_indices); // this was temporary also
-        bitset_destroy(phi_t_neighbourhood); // again, used for intersecting neighs
+        free(profile->results);
+        profile->results = results;
+        profile->results_cap = new_cap;
     }
 
+    result_t *r = profile->results + seq % profile->results_cap;
+    r->k = k;
+    r->decided = decided;
+    r->pops = pops;
+    r->timed_out = timed_out;
+    r->ready = TRUE;
 
-    free(cached_tuple);
-    destroy_graph(tensor_graph);
-    vertice_queue_destroy(q);
-
-    bool satisfied = 0;
-    /*
-     *  Checks whether there exists an empty position bitset_set (all 0)
-     */
-    for (u32 i = 0; i < N; ++i) {
-        bitset_t *v = phi[i];
-        neigh_list_t *t = adjacency_list + i;
-
-        if (t->len > 0) {
-            free(t->list);
+    while ((r = profile->results + profile->next_seq % profile->results_cap)->ready) {
+        if (r->timed_out) {
+            printf("timeout at %d", r->k);
+        } else {
+            printf("%d", r->k);
         }
-
-        if (!satisfied && !bitset_any(v)) {
-            satisfied = TRUE;
+        if (profile->args->bounds_report && !r->timed_out) {
+            printf(" %s", bound_name(r->decided));
         }
-        // We will bitset_not used this array anymore; get rid of it
-        bitset_destroy(v);
+        if (profile->args->pops_report) {
+            printf(" pops:%llu", r->pops);
+        }
+        printf("\n");
+        r->ready = FALSE;
+        profile->next_seq++;
     }
-
-    free(adjacency_list);
-    free(phi);
-
-    return satisfied;
 }
 
+/**
+ * Take a deferred graph out of the list, with the task lock held
+ * @param profile the task profile
+ * @param any if false, only a graph whose memory is available right now is taken
+ * @return the graph, or null if there is none
+ */
+deferred_t *take_deferred(task_profile_t *profile, bool any) {
+    deferred_t **prev = &profile->deferred;
+    for (deferred_t *d = profile->deferred; NULL != d; d = d->next) {
+        if (any || admission_fits(profile->admission, d->bytes)) {
+            *prev = d->next;
+            return d;
+        }
+        prev = &d->next;
+    }
+    return NULL;
+}
 
-u32 cop_number(graph_t *g, u8 max_k) {
-    u32 k = 1;
+/**
+ * Hand the pending results of a worker to the ordered output
+ * @param worker the worker
+ */
+void flush_results(worker_t *worker) {
+    if (0 == worker->pending_sz) {
+        return;
+    }
 
-    while (!bonato_al_algo2(g, k)) {
-        k++;
-        if (k > max_k) {
-            printf("Over %d.\n", max_k);
-            return max_k + 1;
-        }
+    task_lock(worker->profile, worker->trace);
+    for (u32 i = 0; i < worker->pending_sz; ++i) {
+        pending_t *p = worker->pending + i;
+        emit_result(worker->profile, p->seq, p->k, p->decided, p->pops, p->timed_out);
     }
+    pthread_mutex_unlock(worker->profile->mut);
 
-    return k;
+    worker->pending_sz = 0;
 }
 
+void *cop_number_worker(void *worker_t_void) {
+    worker_t *worker = (worker_t *) worker_t_void;
+    task_profile_t *profile = worker->profile;
+    args_t *args = profile->args;
 
-/**
- * Print the usage message of the program
- */
-void usage(bool quick) {
-    printf("Usage: path_to_g6 [-h (help)] [-k cop_number] [-w no_workers=1] [-c] [-s] [-a]\n\n");
+    // All the memory for a graph comes from here, and is kept from one graph to the next.
+    // Admission only counts the runs, so under a budget only the first block is kept
+    arena_t *arena = arena_new(WORKER_ARENA_SIZE);
+    size_t arena_keep = NULL != profile->admission ? WORKER_ARENA_SIZE : WORKER_ARENA_KEEP;
+    trace_buffer_t *trace = worker->trace;
+    progress_slot_t *progress = worker->progress;
+    solver_ctx_t ctx = {
+            .arena = arena,
+            .scratch_dir = args->scratch_dir,
+            .resident_budget = args->resident_budget,
+            .engine = args->engine,
+            .tuning = args->tuning,
+            .decided = BOUND_NONE,
+            .admission = profile->admission,
+            .worklist = args->worklist,
+            .time_budget = args->time_budget,
+            .pop_budget = args->pop_budget,
+            .dominance = args->dominance,
+            .trace = trace,
+            .progress_k = NULL != progress ? &progress->k : NULL,
+            .threads = args->run_threads
+    };
 
-    if (!quick) {
-        printf("Copper is a tool to compute the cop number of graphs, stored in the g6 file format. The g6 file format\n");
-        printf("can contain a single or multiple graphs. The tool supports the following commands:");
+    while (TRUE) {
+        // We are ready to work on a graph: one passed over earlier that fits now, if any
+        bool done = line_ring_drained(profile->lines);
+        task_lock(profile, trace);
+        deferred_t *resumed = take_deferred(profile, done);
+        pthread_mutex_unlock(profile->mut);
 
-        const u8 params = 5;
-        char *usage_str[5] = {
-                "-k : the cop maximum cop number to check. Beyond this number, graphs will not be computed.",
-                "-w : the maximum number of workers to use in parallel. The program may decide to not use them all.",
-                "-c : if the computation must be timed using wall clock time (real time).",
-                "-s : silent mode, does not print a description of received parameters.",
-                "-a : aggregate mode, will not print the graph's cop number, but will print a table aggregating the result. Requires -k specified."
-        };
+        line_slot_t *slot = NULL;
+        u64 start = trace_now(trace);
+        if (NULL == resumed && NULL == (slot = line_ring_take(profile->lines))) {
+            trace_span(trace, TRACE_INPUT, start, 0, 0);
+            // The input is exhausted; only passed over graphs may be left
+            done = TRUE;
+            task_lock(profile, trace);
+            resumed = take_deferred(profile, TRUE);
+            pthread_mutex_unlock(profile->mut);
 
-        for (u8 i = 0; i < params; ++i) {
-            printf("\t%s\n", usage_str[i]);
+            if (NULL == resumed) {
+                break;
+            }
         }
 
-    }
-}
+        if (NULL != slot) {
+            trace_span(trace, TRACE_INPUT, start, 0, 0);
+        }
 
-typedef struct {
-    pthread_mutex_t *mut;
-    pthread_mutex_t *aggr_mut;
-    pthread_cond_t *consume;
-    pthread_cond_t *produce;
-    u32 *breakdown;
-    char *line;
-    args_t *args;
-    bool done;
-} task_profile_t;
+        // Decode the graph; the lines and the graphs are ours, no lock is needed
+        graph_t *g;
+        u64 index, seq;
+        char *line = NULL;
+        start = trace_now(trace);
+        if (NULL != resumed) {
+            g = from_g6_in(arena, resumed->line);
+            index = resumed->index;
+            seq = resumed->seq;
+            ctx.start_k = resumed->k;
+            // Once the input is exhausted there is nothing left to pass over to
+            ctx.may_defer = !done;
+            line = resumed->line;
+        } else {
+            char *text = slot->line + slot->skip;
+            progress_input(progress, slot->skip + strlen(text));
+            g = from_g6_in(arena, text);
+            index = slot->index;
+            seq = slot->seq;
+            ctx.start_k = 0;
+            ctx.may_defer = NULL != profile->admission;
+            if (ctx.may_defer || NULL != args->retry) {
+                // The slot is read into again; keep a copy in case we pass over this one,
+                // or it runs out of budget
+                size_t len = strlen(text) + 1;
+                line = memcpy(arena_alloc(arena, len), text, len);
+            }
+            line_ring_release(profile->lines, slot);
+        }
+        trace_graph(trace, index);
+        trace_span(trace, TRACE_DECODE, start, NULL != g ? g->n : 0, 0);
+        progress_graph(progress, index, NULL != g ? g->n : 0);
+
+        certificate_t cert = {0};
+        ctx.cert = args->certificates ? &cert : NULL;
+        u32 k;
+        bound_kind_t decided = BOUND_NONE;
+        u64 pops = NULL != resumed ? resumed->pops : 0;
+        bool timed_out = FALSE;
+        if (NULL == g) {
+            // Too large to even decode; counted like a graph over the maximum
+            printf("Graph %llu is too large to decode. Skipping.\n", index);
+            k = args->max_cop + 1;
+        } else {
+            k = cop_number(g, args->max_cop, &ctx);
+            decided = ctx.decided;
+            pops += ctx.pops;
+            if (0 != ctx.timeout_k) {
+                timed_out = TRUE;
+                k = ctx.timeout_k;
+            }
+        }
 
-void *cop_number_worker(void *task_profile_t_void) {
-    task_profile_t *profile = (task_profile_t *) task_profile_t_void;
-    args_t *args = profile->args;
+        if (0 == k) {
+            // Not enough memory right now; keep the line to come back to it
+            deferred_t *d = resumed;
+            if (NULL == d) {
+                d = malloc(sizeof(deferred_t));
+                d->line = strdup(line);
+                d->index = index;
+                d->seq = seq;
+            }
+            d->k = ctx.deferred_k;
+            d->bytes = ctx.deferred_bytes;
+            d->pops = pops;
 
-    while (TRUE) {
-        // We are ready to work on a graph
-        pthread_mutex_lock(profile->mut);
+            task_lock(profile, trace);
+            d->next = profile->deferred;
+            profile->deferred = d;
+            pthread_mutex_unlock(profile->mut);
 
-        while (!profile->done && NULL == profile->line) {
-            pthread_cond_wait(profile->consume, profile->mut);
+            certificate_clear(&cert);
+            arena_trim(arena, arena_keep);
+            progress_idle(progress, FALSE);
+            continue;
         }
 
-        if (profile->done) {
-            // If work is done, bail out
+        if (timed_out && NULL != args->retry) {
+            // To be run again separately, with more resources
+            task_lock(profile, trace);
+            fputs(line, args->retry);
+            if ('\n' != line[strlen(line) - 1]) {
+                fputc('\n', args->retry);
+            }
             pthread_mutex_unlock(profile->mut);
-            break;
         }
 
-        // We got the following task
-        graph_t *g = from_g6(profile->line);
-        // Tell we received the task, are ready to continue
-        profile->line = NULL;
-        pthread_cond_signal(profile->produce);
-        // We do not need access to those variables
-        pthread_mutex_unlock(profile->mut);
-
-        u32 k = cop_number(g, args->max_cop);
-        destroy_graph(g);
+        if (NULL != resumed) {
+            free(resumed->line);
+            free(resumed);
+        }
 
-        // We need to update the breakdown
-        // Since this is updated by all workers, we keep it
-        // locked.
-        if (args->aggregate) {
-            pthread_mutex_lock(profile->aggr_mut);
+        if (args->certificates) {
+            // Certificates of different graphs must not interleave
+            task_lock(profile, trace);
+            if (timed_out) {
+                fprintf(args->certificates, "graph %llu timeout at %u\n", index, k);
+            } else if (NULL != cert.strategy) {
+                fprintf(args->certificates, "graph %llu c=%u\n", index, k);
+                certificate_write(args->certificates, g, &cert);
+            } else {
+                fprintf(args->certificates, "graph %llu over %d\n", index, args->max_cop);
+            }
+            pthread_mutex_unlock(profile->mut);
+            certificate_clear(&cert);
+        }
 
-            profile->breakdown[k - 1] += 1;
+        arena_trim(arena, arena_keep);
+        progress_idle(progress, TRUE);
 
-            pthread_mutex_unlock(profile->aggr_mut);
+        // Both are the worker's own; the aggregate is summed after the join, and
+        // results are handed to the ordered output a batch at a time
+        if (args->aggregate) {
+            if (timed_out) {
+                worker->timeouts += 1;
+            } else {
+                worker->breakdown[k - 1] += 1;
+                worker->decided_by[decided] += 1;
+            }
+            worker->pops += pops;
         } else {
-            pthread_mutex_lock(profile->mut);
-            printf("%d\n", k);
-            pthread_mutex_unlock(profile->mut);
+            pending_t *p = worker->pending + worker->pending_sz++;
+            p->seq = seq;
+            p->k = k;
+            p->decided = decided;
+            p->pops = pops;
+            p->timed_out = timed_out;
+            if (worker->batch == worker->pending_sz) {
+                flush_results(worker);
+            }
         }
     }
 
+    flush_results(worker);
+    arena_destroy(arena);
+
     return NULL;
 }
 
 
+/**
+ * Estimate the cost of a graph from its line, for longest-first scheduling. The fixed
+ * point grows as n^k, so n comes first; for the same n, sparser graphs tend to need
+ * more cops, and the cheap bounds settle fewer of them, so they come first.
+ * @param line the g6 line
+ * @return the cost, only meaningful compared to others
+ */
+u64 schedule_cost(char *line) {
+    u64 n, edges;
+    g6_shape(line, &n, &edges);
+
+    u64 missing = n * (n - 1) / 2 - edges;
+    if (0 == n || edges > n * (n - 1) / 2) {
+        missing = 0;
+    }
+    return (n << 32) | (missing > 0xFFFFFFFFULL ? 0xFFFFFFFFULL : missing);
+}
+
 bool handle_file(char *file_path, args_t *args) {
     bool ok = TRUE;
     FILE *f = NULL;
 
-    u32 *breakdown = NULL;
-    bool aggregate;
-    i32 max_cop;
-
-    if ((aggregate = args->aggregate)) {
-        breakdown = malloc(sizeof(u32) * (max_cop = args->max_cop));
-        for (i32 k = 0; k < max_cop; ++k) {
-            breakdown[k] = 0;
-        }
-    }
+    bool aggregate = args->aggregate;
+    // One more slot for the graphs over the maximum
+    i32 max_cop = args->max_cop;
+    u32 slots = aggregate ? max_cop + 1 : 0;
 
     task_profile_t task;
-    pthread_mutex_t aggr_mut, task_mut;
-    pthread_cond_t produce, consume;
+    pthread_mutex_t task_mut;
+    line_ring_t lines;
+
+    // Scheduling by cost needs the window on top of the lines the workers are decoding
+    u32 ahead = PREFETCH_PER_WORKER * args->workers;
+    if (args->longest_first > 0 && args->longest_first + args->workers > ahead) {
+        ahead = args->longest_first + args->workers;
+    }
+    line_ring_init(&lines, ahead, args->longest_first > 0);
 
     task.mut = &task_mut;
-    task.produce = &produce;
-    task.consume = &consume;
-    task.line = NULL;
-    task.breakdown = breakdown;
-    task.done = FALSE;
+    task.lines = &lines;
+    task.next_seq = 0;
+    task.results_cap = 2 * args->workers;
+    task.results = calloc(task.results_cap, sizeof(result_t));
     task.args = args;
+    task.deferred = NULL;
+    task.admission = NULL;
 
-    if (aggregate) {
-        task.aggr_mut = &aggr_mut;
-        pthread_mutex_init(task.aggr_mut, NULL);
+    admission_t admission;
+    if (args->mem_budget > 0) {
+        admission_init(&admission, args->mem_budget);
+        task.admission = &admission;
     }
 
     pthread_mutex_init(task.mut, NULL);
-    pthread_cond_init(task.produce, NULL);
-    pthread_cond_init(task.consume, NULL);
 
     pthread_t *worker_list = malloc(sizeof(pthread_t) * args->workers);
+    worker_t *workers = calloc(args->workers, sizeof(worker_t));
+
+    // Reports on SIGUSR1 even without periodic lines; runs without it if it cannot start
+    progress_t progress;
+    bool reporting = progress_start(&progress, args->workers, 0, args->progress);
 
     for (u8 i = 0; i < args->workers; ++i) {
-        pthread_create(worker_list + i, NULL, cop_number_worker, &task);
+        workers[i].profile = &task;
+        workers[i].breakdown = calloc(slots, sizeof(u64));
+        workers[i].batch = args->workers > 1 ? RESULT_BATCH : 1;
+        workers[i].trace = trace_buffer_new(args->trace);
+        workers[i].progress = reporting ? progress.slots + i : NULL;
+        pthread_create(worker_list + i, NULL, cop_number_worker, workers + i);
     }
 
-    if (NULL == (f = fopen(file_path, "r"))) {
+    // "-" is the standard input, typically geng's output piped in
+    bool from_stdin = 0 == strcmp("-", file_path);
+    if (NULL == (f = from_stdin ? stdin : fopen(file_path, "r"))) {
         ok = FALSE;
     } else {
-        char *line = NULL;
-        size_t len = 0;
-        bool first_line = TRUE;
-        while (-1 != getline(&line, &len, f)) {
-            char *line_to_read;
-            if (first_line && 0 == strncmp(G6_HEADER, line, G6_HEADER_LEN)) {
-                if ('\0' == line[G6_HEADER_LEN]) {
-                    // The only line in the file was this header
-                    continue;
-                }
-                line_to_read = line + G6_HEADER_LEN;
+        u64 index = 0;
+        u64 seq = 0;
+        // The slot being read into; its buffer is also used to skip lines
+        line_slot_t *slot = line_ring_acquire(&lines);
+
+        // Lines starting before this offset are ours (-1 for all of them)
+        off_t end = -1;
+        // The offset of the next line; counted rather than asked for, since pipes cannot tell
+        off_t at = 0;
+        ssize_t read;
+        struct stat info;
+        if (reporting && 0 == fstat(fileno(f), &info) && S_ISREG(info.st_mode)) {
+            // A shard by bytes sets its own range below
+            progress_total(&progress, (u64) info.st_size / (args->shard_by_lines ? args->shard_count : 1));
+        }
+        if (args->shard_count > 1 && !args->shard_by_lines) {
+            fstat(fileno(f), &info);
+            if (!S_ISREG(info.st_mode)) {
+                printf("A stream cannot be sharded by bytes, use --shard-by lines. Aborting.\n");
+                ok = FALSE;
+                end = 0;
             } else {
-                line_to_read = line;
+                off_t start = info.st_size * args->shard_index / args->shard_count;
+                end = info.st_size * (args->shard_index + 1) / args->shard_count;
+                if (reporting) {
+                    progress_total(&progress, (u64) (end - start));
+                }
+
+                if (start > 0) {
+                    // The line that straddles the start belongs to the previous shard
+                    fseeko(f, start - 1, SEEK_SET);
+                    if (-1 == (read = getline(&slot->line, &slot->cap, f))) {
+                        end = 0;
+                    } else {
+                        at = start - 1 + read;
+                    }
+                }
             }
-            first_line = FALSE;
+        }
 
-            /*
-             * Send the task to a worker
-             */
-            pthread_mutex_lock(task.mut);
+        while (TRUE) {
+            if ((end >= 0 && at >= end) || -1 == (read = getline(&slot->line, &slot->cap, f))) {
+                break;
+            }
+            at += read;
 
-            task.line = line_to_read;
-            pthread_cond_signal(task.consume);
+            slot->skip = 0;
+            if (at == read && 0 == strncmp(G6_HEADER, slot->line, G6_HEADER_LEN)) {
+                slot->skip = G6_HEADER_LEN;
+            }
 
-            while (NULL != task.line) {
-                pthread_cond_wait(task.produce, task.mut);
+            char first = slot->line[slot->skip];
+            if ('\n' == first || '\r' == first || '\0' == first) {
+                // Blank, or the header was alone on its line
+                continue;
             }
 
-            pthread_mutex_unlock(task.mut);
+            if (args->shard_by_lines && index++ % args->shard_count != args->shard_index) {
+                continue;
+            }
+
+            /*
+             * Send the line to the workers, and read the next one ahead while they decode
+             */
+            // Shards by bytes cannot know how many graphs come before theirs
+            slot->index = args->shard_by_lines ? index - 1 : seq;
+            slot->seq = seq++;
+            if (args->longest_first > 0) {
+                slot->cost = schedule_cost(slot->line + slot->skip);
+            }
+            line_ring_publish(&lines, slot);
+            slot = line_ring_acquire(&lines);
         }
-        free(line);
+
+        line_ring_release(&lines, slot);
     }
 
-    pthread_mutex_lock(task.mut);
-    task.done = TRUE;
     // Wake up the ones that are waiting
-    pthread_cond_broadcast(task.consume);
-    pthread_mutex_unlock(task.mut);
+    line_ring_close(&lines);
 
     // Wait for all workers to finish; do not have the
     // full results yet
     for (u8 i = 0; i < args->workers; ++i) {
         pthread_join(worker_list[i], NULL);
     }
+    if (reporting) {
+        progress_stop(&progress);
+    }
 
     if (aggregate) {
-        for (u32 k = 0; k < max_cop; ++k) {
-            printf("%d ", breakdown[k]);
+        for (i32 k = 0; k < max_cop; ++k) {
+            u64 sum = 0;
+            for (u8 i = 0; i < args->workers; ++i) {
+                sum += workers[i].breakdown[k];
+            }
+            printf("%llu ", sum);
         }
         printf("\n");
+
+        if (args->bounds_report) {
+            for (u32 b = 0; b < BOUND_KINDS; ++b) {
+                u64 sum = 0;
+                for (u8 i = 0; i < args->workers; ++i) {
+                    sum += workers[i].decided_by[b];
+                }
+                printf("%s:%llu ", bound_name(b), sum);
+            }
+            printf("\n");
+        }
+
+        if (args->pops_report) {
+            u64 sum = 0;
+            for (u8 i = 0; i < args->workers; ++i) {
+                sum += workers[i].pops;
+            }
+            printf("worklist:%s pops:%llu \n", worklist_name(args->worklist), sum);
+        }
+
+        if (args->time_budget > 0 || 0 != args->pop_budget) {
+            u64 sum = 0;
+            for (u8 i = 0; i < args->workers; ++i) {
+                sum += workers[i].timeouts;
+            }
+            printf("timeout:%llu \n", sum);
+        }
     }
 
-    if (aggregate) {
-        pthread_mutex_destroy(task.aggr_mut);
+    for (u8 i = 0; i < args->workers; ++i) {
+        free(workers[i].breakdown);
+    }
+    free(workers);
+
+    if (NULL != task.admission) {
+        admission_destroy(task.admission);
     }
 
     pthread_mutex_destroy(task.mut);
-    pthread_cond_destroy(task.produce);
-    pthread_cond_destroy(task.consume);
+    line_ring_destroy(&lines);
 
     free(worker_list);
+    free(task.results);
 
-    if (NULL != f) {
+    if (NULL != f && !from_stdin) {
         fclose(f);
     }
 
-    if (breakdown) {
-        free(breakdown);
-    }
-
     return ok;
 }
 
@@ -422,20 +763,69 @@ int main(int argc, char *argv[]) {
     take_time = aggregate = silent = FALSE;
     i32 max_cop = -1;
     u8 workers = 1;
+    FILE *certificates = NULL;
+    bool bounds_report = FALSE;
+    char *scratch_dir = NULL;
+    size_t resident_mb = DEFAULT_RESIDENT_MB;
+    size_t mem_budget_mb = 0;
+    engine_t engine = ENGINE_AUTO;
+    worklist_policy_t worklist = WORKLIST_AUTO;
+    bool pops_report = FALSE;
+    bool dominance = FALSE;
+    double time_budget = 0;
+    u64 pop_budget = 0;
+    FILE *retry = NULL;
+    FILE *trace_out = NULL;
+    double progress = 0;
+    trace_t trace;
+    engine_tuning_t tuning;
+    tuning_default(&tuning);
 
     time_t before = time(NULL);
 
+    // Results leave in large chunks when nobody is watching them come
+    if (!isatty(STDOUT_FILENO)) {
+        setvbuf(stdout, NULL, _IOFBF, OUTPUT_BUFFER);
+    }
+
     /*
      * Parse the options
      */
-    if (1 == argc) {
+    if (1 == argc && isatty(STDIN_FILENO)) {
+        // Nothing given, and nothing piped in either
         USAGE_AND_LEAVE();
     }
 
-    char *path = argv[1];
+    if (argc > 1 && 0 == strcmp("merge", argv[1])) {
+        return merge_main(argc - 1, argv + 1);
+    }
+    u32 shard_index = 0, shard_count = 1;
+    bool shard_by_lines = FALSE;
+    u32 longest_first = 0;
+    u32 run_threads = 1;
+
+    static struct option long_options[] = {
+            {"mem-budget", required_argument, NULL, 'M'},
+            {"engine",     required_argument, NULL, 'E'},
+            {"worklist",   required_argument, NULL, 'W'},
+            {"pops",       no_argument,       NULL, 'P'},
+            {"dominance",  no_argument,       NULL, 'D'},
+            {"time-budget", required_argument, NULL, 'U'},
+            {"pop-budget", required_argument, NULL, 'N'},
+            {"retry",      required_argument, NULL, 'R'},
+            {"trace",      required_argument, NULL, 'I'},
+            {"progress",   required_argument, NULL, 'G'},
+            {"tuning",     required_argument, NULL, 'T'},
+            {"calibrate",  required_argument, NULL, 'C'},
+            {"shard",      required_argument, NULL, 'S'},
+            {"shard-by",   required_argument, NULL, 'B'},
+            {"longest-first", required_argument, NULL, 'L'},
+            {"run-threads", required_argument, NULL, 'H'},
+            {NULL, 0, NULL, 0}
+    };
 
     int c;
-    while ((c = getopt(argc, argv, "hacsk:w:")) != -1) {
+    while ((c = getopt_long(argc, argv, "hacsbk:w:x:o:r:", long_options, NULL)) != -1) {
         switch (c) {
             case 'h':
                 usage(FALSE);
@@ -449,12 +839,107 @@ int main(int argc, char *argv[]) {
             case 's':
                 silent = TRUE;
                 break;
+            case 'b':
+                bounds_report = TRUE;
+                break;
+            case 'o':
+                scratch_dir = optarg;
+                break;
+            case 'r':
+                resident_mb = strtoul(optarg, NULL, 10);
+                break;
+            case 'M':
+                mem_budget_mb = strtoul(optarg, NULL, 10);
+                break;
+            case 'S':
+                if (2 != sscanf(optarg, "%u/%u", &shard_index, &shard_count) ||
+                    0 == shard_count || shard_index >= shard_count) {
+                    printf("The shard must be given as i/m, with 0 <= i < m. Aborting.\n");
+                    return 1;
+                }
+                break;
+            case 'B':
+                if (0 == strcmp("lines", optarg)) {
+                    shard_by_lines = TRUE;
+                } else if (0 != strcmp("bytes", optarg)) {
+                    printf("Shards are by bytes or by lines. Aborting.\n");
+                    return 1;
+                }
+                break;
+            case 'L':
+                longest_first = strtoul(optarg, NULL, 10);
+                break;
+            case 'H':
+                run_threads = strtoul(optarg, NULL, 10);
+                break;
+            case 'E':
+                if (!engine_from_name(optarg, &engine)) {
+                    printf("Unknown engine %s. Aborting.\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'W':
+                if (!worklist_from_name(optarg, &worklist)) {
+                    printf("Unknown worklist policy %s. Aborting.\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'P':
+                pops_report = TRUE;
+                break;
+            case 'D':
+                dominance = TRUE;
+                break;
+            case 'U':
+                time_budget = strtod(optarg, NULL);
+                break;
+            case 'N':
+                pop_budget = strtoull(optarg, NULL, 10);
+                break;
+            case 'R':
+                if (NULL == (retry = fopen(optarg, "w"))) {
+                    printf("Failed to open the retry file. Aborting.\n");
+                    return 1;
+                }
+                break;
+            case 'G':
+                progress = strtod(optarg, NULL);
+                break;
+            case 'I':
+                if (NULL == (trace_out = fopen(optarg, "w"))) {
+                    printf("Failed to open the trace file. Aborting.\n");
+                    return 1;
+                }
+                break;
+            case 'T':
+                if (!tuning_load(&tuning, optarg)) {
+                    printf("Failed to read the tuning file. Aborting.\n");
+                    return 1;
+                }
+                break;
+            case 'C': {
+                FILE *out = fopen(optarg, "w");
+                if (NULL == out) {
+                    printf("Failed to open the tuning file. Aborting.\n");
+                    return 1;
+                }
+                tuning_calibrate(&tuning, stdout);
+                tuning_write(&tuning, out);
+                fclose(out);
+                return 0;
+            }
             case 'k':
                 max_cop = atoi(optarg);
                 break;
             case 'w':
                 workers = atoi(optarg);
                 break;
+            case 'x':
+                if (NULL == (certificates = fopen(optarg, "w"))) {
+                    printf("Failed to open the certificate file. Aborting.\n");
+                    return 1;
+                }
+                break;
             case '?':
                 USAGE_AND_LEAVE();
             default:
@@ -462,6 +947,13 @@ int main(int argc, char *argv[]) {
         }
     }
 
+    // Only the materialized engine has a worklist; any other would run under the policy's name
+    if (WORKLIST_AUTO != worklist && ENGINE_AUTO != engine && ENGINE_MATERIALIZED != engine) {
+        printf("The %s engine has no worklist, --worklist needs the auto or materialized engine. Aborting.\n",
+               engine_name(engine));
+        return 1;
+    }
+
     if (!silent) {
         printf("Samuel Yvon\n");
         printf("Cop Number Calculator\n");
@@ -483,7 +975,27 @@ int main(int argc, char *argv[]) {
     args_t args = {
             aggregate,
             max_cop,
-            workers
+            workers,
+            certificates,
+            bounds_report,
+            scratch_dir,
+            resident_mb << 20,
+            mem_budget_mb << 20,
+            engine,
+            &tuning,
+            worklist,
+            pops_report,
+            dominance,
+            time_budget,
+            pop_budget,
+            retry,
+            NULL,
+            progress,
+            shard_index,
+            shard_count,
+            shard_by_lines,
+            longest_first,
+            run_threads
     };
 
     if (aggregate && (max_cop < 0)) {
@@ -491,8 +1003,21 @@ int main(int argc, char *argv[]) {
         return 1;
     }
 
+    if (NULL != trace_out) {
+        trace_init(&trace, TRACE_DEFAULT_EVENTS);
+        args.trace = &trace;
+    }
+
+    // The path is the argument left over once the options are parsed; without one, read stdin
+    char *path = optind < argc ? argv[optind] : "-";
+
+    // Before the workers exist, so that only the progress report takes it
+    progress_block_signal();
+
     struct stat path_info;
-    if (0 == stat(path, &path_info)) {
+    if (0 == strcmp("-", path)) {
+        handle_file(path, &args);
+    } else if (0 == stat(path, &path_info)) {
         if (path_info.st_mode & S_IFDIR) {
             handle_folder(path, &args);
         } else {
@@ -503,6 +1028,20 @@ int main(int argc, char *argv[]) {
         exit(1);
     }
 
+    if (NULL != certificates) {
+        fclose(certificates);
+    }
+
+    if (NULL != retry) {
+        fclose(retry);
+    }
+
+    if (NULL != trace_out) {
+        trace_write(&trace, trace_out);
+        fclose(trace_out);
+        trace_destroy(&trace);
+    }
+
     if (take_time) {
         time_t duration = time(NULL) - before;
         printf("Duration: %ld second(s)", duration);
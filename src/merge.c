@@ -0,0 +1,275 @@
+#include "merge.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <getopt.h>
+#include "types.h"
+
+/**
+ * The meaningful lines of a shard output
+ */
+typedef struct {
+    char **lines;
+    u32 len;
+    u32 cap;
+    // Reading cursor, used when merging
+    u32 at;
+} shard_output_t;
+
+/**
+ * Whether a token is progress noise printed by the solver: the "4, " printed for
+ * each k >= 4 tried, and the "Over k." printed when a graph is beyond the maximum
+ * @param token the token
+ * @param previous the token before it
+ */
+static bool is_noise(const char *token, const char *previous) {
+    size_t len = strlen(token);
+    size_t digits = strspn(token, "0123456789");
+
+    if (0 == strcmp("Over", token)) {
+        return TRUE;
+    }
+
+    return digits > 0 && digits + 1 == len && ((',' == token[digits]) ||
+                                               ('.' == token[digits] && NULL != previous &&
+                                                0 == strcmp("Over", previous)));
+}
+
+/**
+ * Read the lines of a shard output, without the progress noise. The noise may be
+ * printed in the middle of a line (after a file name, in folder mode), which then
+ * continues on the next line.
+ * @param path the file
+ * @param out the lines read
+ * @return if the file could be read
+ */
+static bool read_shard(const char *path, shard_output_t *out) {
+    FILE *f = fopen(path, "r");
+    if (NULL == f) {
+        return FALSE;
+    }
+
+    out->lines = NULL;
+    out->len = out->cap = out->at = 0;
+
+    char *line = NULL;
+    size_t len = 0;
+    ssize_t read;
+
+    // What is kept of the current line, and of the lines it continues
+    char *clean = NULL;
+    size_t clean_len = 0;
+
+    while (-1 != (read = getline(&line, &len, f))) {
+        clean = realloc(clean, clean_len + read + 2);
+
+        char *save;
+        char *previous = NULL;
+        bool ends_in_noise = FALSE;
+        for (char *token = strtok_r(line, " \r\n", &save); NULL != token; token = strtok_r(NULL, " \r\n", &save)) {
+            ends_in_noise = is_noise(token, previous);
+            if (!ends_in_noise) {
+                if (clean_len > 0) {
+                    clean[clean_len++] = ' ';
+                }
+                size_t token_len = strlen(token);
+                memcpy(clean + clean_len, token, token_len);
+                clean_len += token_len;
+            }
+            previous = token;
+        }
+        clean[clean_len] = '\0';
+
+        if (ends_in_noise || 0 == clean_len) {
+            continue;
+        }
+
+        if (out->len == out->cap) {
+            out->cap = out->cap ? 2 * out->cap : 64;
+            out->lines = realloc(out->lines, sizeof(char *) * out->cap);
+        }
+        out->lines[out->len++] = strdup(clean);
+        clean_len = 0;
+    }
+
+    free(clean);
+    free(line);
+    fclose(f);
+
+    return TRUE;
+}
+
+/**
+ * Whether a line is the result of a graph (it starts with the cop number, or says the
+ * graph ran out of budget)
+ */
+static bool is_result(const char *line) {
+    return 0 != isdigit((unsigned char) line[0]) || 0 == strncmp("timeout at ", line, 11);
+}
+
+/**
+ * Sum the aggregate tables of the shards, line by line and column by column
+ * @return if the shards had the same shape
+ */
+static bool merge_aggregate(shard_output_t *shards, u32 count) {
+    for (u32 s = 1; s < count; ++s) {
+        if (shards[s].len != shards[0].len) {
+            return FALSE;
+        }
+    }
+
+    for (u32 i = 0; i < shards[0].len; ++i) {
+        char *saves[count];
+        char *tokens[count];
+
+        for (u32 s = 0; s < count; ++s) {
+            tokens[s] = strtok_r(shards[s].lines[i], " ", saves + s);
+        }
+
+        while (NULL != tokens[0]) {
+            char *colon = strchr(tokens[0], ':');
+            unsigned long sum = 0;
+            bool numeric = 0 != isdigit((unsigned char) (NULL != colon ? colon[1] : tokens[0][0]));
+
+            for (u32 s = 0; s < count; ++s) {
+                if (NULL == tokens[s]) {
+                    return FALSE;
+                }
+                char *value = strchr(tokens[s], ':');
+                value = NULL != value ? value + 1 : tokens[s];
+                if (numeric) {
+                    sum += strtoul(value, NULL, 10);
+                } else if (0 != strcmp(tokens[s], tokens[0])) {
+                    // File names, in folder mode, must line up
+                    return FALSE;
+                }
+            }
+
+            if (!numeric) {
+                printf("%s ", tokens[0]);
+            } else if (NULL != colon) {
+                printf("%.*s:%lu ", (int) (colon - tokens[0]), tokens[0], sum);
+            } else {
+                printf("%lu ", sum);
+            }
+
+            for (u32 s = 0; s < count; ++s) {
+                tokens[s] = strtok_r(NULL, " ", saves + s);
+            }
+        }
+        printf("\n");
+    }
+
+    return TRUE;
+}
+
+/**
+ * Put the per graph results of the shards back in input order. Folder runs print a
+ * file name before the results of each file; the results are merged file by file.
+ * @param by_lines if the shards are every m-th graph (interleave) rather than byte ranges (concatenate)
+ * @return if the shards had the same files
+ */
+static bool merge_results(shard_output_t *shards, u32 count, bool by_lines) {
+    while (TRUE) {
+        // Every shard is at the start of the same file section (or at the end)
+        bool end = shards[0].at == shards[0].len;
+        for (u32 s = 1; s < count; ++s) {
+            if ((shards[s].at == shards[s].len) != end) {
+                return FALSE;
+            }
+        }
+        if (end) {
+            return TRUE;
+        }
+
+        char *name = shards[0].lines[shards[0].at];
+        if (!is_result(name)) {
+            for (u32 s = 0; s < count; ++s) {
+                if (0 != strcmp(name, shards[s].lines[shards[s].at++])) {
+                    return FALSE;
+                }
+            }
+            printf("%s\n", name);
+        }
+
+        if (by_lines) {
+            // Graph j went to shard j % m
+            bool any = TRUE;
+            while (any) {
+                any = FALSE;
+                for (u32 s = 0; s < count; ++s) {
+                    shard_output_t *o = shards + s;
+                    if (o->at < o->len && is_result(o->lines[o->at])) {
+                        printf("%s\n", o->lines[o->at++]);
+                        any = TRUE;
+                    } else {
+                        // This shard is done with the file; so are the ones after it this round
+                        break;
+                    }
+                }
+            }
+        } else {
+            for (u32 s = 0; s < count; ++s) {
+                shard_output_t *o = shards + s;
+                while (o->at < o->len && is_result(o->lines[o->at])) {
+                    printf("%s\n", o->lines[o->at++]);
+                }
+            }
+        }
+    }
+}
+
+int merge_main(int argc, char *argv[]) {
+    bool aggregate = FALSE;
+    bool by_lines = FALSE;
+
+    static struct option long_options[] = {
+            {"shard-by", required_argument, NULL, 'B'},
+            {NULL, 0, NULL, 0}
+    };
+
+    int c;
+    while ((c = getopt_long(argc, argv, "a", long_options, NULL)) != -1) {
+        switch (c) {
+            case 'a':
+                aggregate = TRUE;
+                break;
+            case 'B':
+                by_lines = (0 == strcmp("lines", optarg));
+                break;
+            default:
+                printf("Usage: merge [-a] [--shard-by bytes|lines] shard_outputs...\n");
+                return 1;
+        }
+    }
+
+    u32 count = argc - optind;
+    if (0 == count) {
+        printf("No shard output to merge. Aborting.\n");
+        return 1;
+    }
+
+    shard_output_t *shards = malloc(sizeof(shard_output_t) * count);
+    for (u32 s = 0; s < count; ++s) {
+        if (!read_shard(argv[optind + s], shards + s)) {
+            printf("Failed to read %s. Aborting.\n", argv[optind + s]);
+            return 1;
+        }
+    }
+
+    bool ok = aggregate ? merge_aggregate(shards, count) : merge_results(shards, count, by_lines);
+    if (!ok) {
+        printf("The shard outputs do not line up. Were they produced by the same run?\n");
+    }
+
+    for (u32 s = 0; s < count; ++s) {
+        for (u32 i = 0; i < shards[s].len; ++i) {
+            free(shards[s].lines[i]);
+        }
+        free(shards[s].lines);
+    }
+    free(shards);
+
+    return ok ? 0 : 1;
+}
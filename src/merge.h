@@ -0,0 +1,15 @@
+#ifndef COPNV2_MERGE_H
+#define COPNV2_MERGE_H
+
+/**
+ * Combine the outputs of the shards of a run (see --shard) into the output a single
+ * run would have given. Aggregate tables are summed; per graph results are put back
+ * in input order, by concatenating shards by bytes or interleaving shards by lines.
+ * The shard outputs must have been produced in silent mode, and be given in shard order.
+ * @param argc the number of arguments, "merge" included
+ * @param argv the arguments: [-a] [--shard-by bytes|lines] files...
+ * @return the exit code
+ */
+int merge_main(int argc, char *argv[]);
+
+#endif //COPNV2_MERGE_H
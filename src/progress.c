@@ -0,0 +1,178 @@
+#include "progress.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <time.h>
+
+/**
+ * The time, for the rates
+ * @return seconds on the monotonic clock
+ */
+static double progress_clock(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (double) t.tv_sec + (double) t.tv_nsec / 1e9;
+}
+
+/**
+ * Print a number of bytes in the unit that suits it
+ * @param bytes the number of bytes
+ */
+static void progress_size(u64 bytes) {
+    const char *units[] = {"B", "KB", "MB", "GB", "TB"};
+    double size = (double) bytes;
+    u8 unit = 0;
+    while (size >= 1024 && unit < 4) {
+        size /= 1024;
+        unit++;
+    }
+    fprintf(stderr, unit > 0 ? "%.1f %s" : "%.0f %s", size, units[unit]);
+}
+
+/**
+ * Print the time left
+ * @param seconds the time left
+ */
+static void progress_eta(double seconds) {
+    u64 eta = (u64) seconds;
+    fprintf(stderr, ", ETA %lluh%02llum%02llus", eta / 3600, eta / 60 % 60, eta % 60);
+}
+
+/**
+ * Sum the workers' counters into the window
+ * @param p the report
+ * @return where the sample went in the window
+ */
+static u32 progress_sample(progress_t *p) {
+    u64 done = 0, bytes = 0;
+    for (u8 i = 0; i < p->workers; ++i) {
+        done += __atomic_load_n(&p->slots[i].done, __ATOMIC_RELAXED);
+        bytes += __atomic_load_n(&p->slots[i].bytes, __ATOMIC_RELAXED);
+    }
+
+    u32 at = p->samples++ % PROGRESS_WINDOW;
+    p->sample_time[at] = progress_clock();
+    p->sample_done[at] = done;
+    p->sample_bytes[at] = bytes;
+    return at;
+}
+
+/**
+ * Take a sample, and report the status on stderr
+ * @param p the report
+ * @param workers if the status of every worker is wanted as well
+ */
+static void progress_report(progress_t *p, bool workers) {
+    u32 at = progress_sample(p);
+    // The oldest sample of the window
+    u32 oldest = p->samples > PROGRESS_WINDOW ? p->samples % PROGRESS_WINDOW : 0;
+    u64 done = p->sample_done[at], bytes = p->sample_bytes[at];
+
+    double span = p->sample_time[at] - p->sample_time[oldest];
+    double graph_rate = span > 0 ? (double) (done - p->sample_done[oldest]) / span : 0;
+    double byte_rate = span > 0 ? (double) (bytes - p->sample_bytes[oldest]) / span : 0;
+
+    fprintf(stderr, "progress: %llu graphs, %.1f graphs/s", done, graph_rate);
+    u64 total = __atomic_load_n(&p->total_bytes, __ATOMIC_RELAXED);
+    fprintf(stderr, ", ");
+    progress_size(bytes);
+    if (0 != total) {
+        fprintf(stderr, " of ");
+        progress_size(total);
+        fprintf(stderr, " (%.0f%%)", 100.0 * (double) bytes / (double) total);
+        if (bytes < total) {
+            if (byte_rate > 0) {
+                progress_eta((double) (total - bytes) / byte_rate);
+            }
+        } else {
+            // Every line is taken, so what is left is the graphs the workers are on
+            u32 running = 0;
+            for (u8 i = 0; i < p->workers; ++i) {
+                running += 0 != __atomic_load_n(&p->slots[i].n, __ATOMIC_RELAXED);
+            }
+            fprintf(stderr, ", input done, %u running", running);
+            if (graph_rate > 0 && running > 0) {
+                progress_eta((double) running / graph_rate);
+            }
+        }
+    }
+    fprintf(stderr, "\n");
+
+    if (workers) {
+        for (u8 i = 0; i < p->workers; ++i) {
+            progress_slot_t *s = p->slots + i;
+            u32 n = __atomic_load_n(&s->n, __ATOMIC_RELAXED);
+            if (0 == n) {
+                fprintf(stderr, "\tworker %u: idle\n", i);
+            } else {
+                fprintf(stderr, "\tworker %u: graph %llu, n=%u, k=%u\n", i, __atomic_load_n(&s->graph, __ATOMIC_RELAXED),
+                        n, __atomic_load_n(&s->k, __ATOMIC_RELAXED));
+            }
+        }
+    }
+}
+
+/**
+ * The reporting thread: samples every second, prints a status line every interval, and
+ * the workers' status on SIGUSR1
+ */
+static void *progress_thread(void *p_void) {
+    progress_t *p = (progress_t *) p_void;
+
+    sigset_t usr1;
+    sigemptyset(&usr1);
+    sigaddset(&usr1, SIGUSR1);
+    struct timespec second = {1, 0};
+
+    double last_line = progress_clock();
+    while (TRUE) {
+        int sig = sigtimedwait(&usr1, NULL, &second);
+        if (__atomic_load_n(&p->stop, __ATOMIC_ACQUIRE)) {
+            break;
+        }
+
+        bool line = p->interval > 0 && progress_clock() - last_line >= p->interval;
+        if (SIGUSR1 == sig || line) {
+            progress_report(p, SIGUSR1 == sig);
+            last_line = progress_clock();
+        } else {
+            progress_sample(p);
+        }
+    }
+
+    return NULL;
+}
+
+void progress_block_signal(void) {
+    sigset_t usr1;
+    sigemptyset(&usr1);
+    sigaddset(&usr1, SIGUSR1);
+    pthread_sigmask(SIG_BLOCK, &usr1, NULL);
+}
+
+bool progress_start(progress_t *p, u8 workers, u64 total_bytes, double interval) {
+    if (NULL == (p->slots = calloc(workers, sizeof(progress_slot_t)))) {
+        return FALSE;
+    }
+    p->workers = workers;
+    p->total_bytes = total_bytes;
+    p->interval = interval;
+    p->stop = FALSE;
+    p->samples = 0;
+    // The window starts now, not at the first tick
+    progress_sample(p);
+
+    if (0 != pthread_create(&p->thread, NULL, progress_thread, p)) {
+        free(p->slots);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+void progress_stop(progress_t *p) {
+    __atomic_store_n(&p->stop, TRUE, __ATOMIC_RELEASE);
+    // Wake it up rather than wait for its next sample
+    pthread_kill(p->thread, SIGUSR1);
+    pthread_join(p->thread, NULL);
+    free(p->slots);
+}
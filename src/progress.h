@@ -0,0 +1,117 @@
+#ifndef COPNV2_PROGRESS_H
+#define COPNV2_PROGRESS_H
+
+#include <pthread.h>
+#include "types.h"
+
+// The throughput is measured over this many seconds
+#define PROGRESS_WINDOW 60
+
+/**
+ * What a worker is doing, as seen by the progress report. The worker writes it and the
+ * report reads it without a lock, through the __atomic builtins only: the fields may not
+ * agree with each other for an instant, which a report can live with.
+ */
+typedef struct {
+    // Graphs finished, and the bytes of input taken
+    u64 done;
+    u64 bytes;
+    // The graph being solved (index in the file and n, 0 when idle), and the k being run
+    u64 graph;
+    u32 n;
+    u32 k;
+} progress_slot_t;
+
+/**
+ * A thread reporting on stderr how a run goes: a status line every interval, and the
+ * status of every worker on SIGUSR1.
+ */
+typedef struct {
+    progress_slot_t *slots;
+    u8 workers;
+    // The bytes of input to take in all, 0 if unknown (a pipe). Only known once the input
+    // is open, so set through the __atomic builtins.
+    u64 total_bytes;
+    // Seconds between status lines, 0 for none (SIGUSR1 still reports)
+    double interval;
+    pthread_t thread;
+    bool stop;
+    // One sample of (time, graphs done, bytes taken) a second, a ring
+    double sample_time[PROGRESS_WINDOW];
+    u64 sample_done[PROGRESS_WINDOW];
+    u64 sample_bytes[PROGRESS_WINDOW];
+    u32 samples;
+} progress_t;
+
+/**
+ * Keep SIGUSR1 for the progress report: it is blocked in the calling thread and in the
+ * threads it creates afterwards, and only the report takes it. Call it before creating
+ * any thread.
+ */
+void progress_block_signal(void);
+
+/**
+ * Start reporting
+ * @param p the structure
+ * @param workers the number of workers
+ * @param total_bytes the bytes of input to take in all, 0 if unknown (see progress_total)
+ * @param interval seconds between status lines, 0 for none
+ * @return if the report started (the slots are then allocated)
+ */
+bool progress_start(progress_t *p, u8 workers, u64 total_bytes, double interval);
+
+/**
+ * Stop reporting, and free the slots
+ * @param p the report
+ */
+void progress_stop(progress_t *p);
+
+/**
+ * Set how much input there is to take, once it is known
+ * @param p the report
+ * @param total_bytes the bytes of input to take in all
+ */
+static inline void progress_total(progress_t *p, u64 total_bytes) {
+    __atomic_store_n(&p->total_bytes, total_bytes, __ATOMIC_RELAXED);
+}
+
+/**
+ * A worker took some input
+ * @param s the worker's slot (may be null)
+ * @param bytes the length of the line
+ */
+static inline void progress_input(progress_slot_t *s, u64 bytes) {
+    if (NULL != s) {
+        __atomic_store_n(&s->bytes, s->bytes + bytes, __ATOMIC_RELAXED);
+    }
+}
+
+/**
+ * A worker starts solving a graph
+ * @param s the worker's slot (may be null)
+ * @param graph the index of the graph
+ * @param n its number of vertices
+ */
+static inline void progress_graph(progress_slot_t *s, u64 graph, u32 n) {
+    if (NULL != s) {
+        __atomic_store_n(&s->graph, graph, __ATOMIC_RELAXED);
+        __atomic_store_n(&s->k, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&s->n, n, __ATOMIC_RELAXED);
+    }
+}
+
+/**
+ * A worker is done with a graph (passed over graphs are not done yet)
+ * @param s the worker's slot (may be null)
+ * @param finished if the graph was solved
+ */
+static inline void progress_idle(progress_slot_t *s, bool finished) {
+    if (NULL != s) {
+        __atomic_store_n(&s->n, 0, __ATOMIC_RELAXED);
+        if (finished) {
+            __atomic_store_n(&s->done, s->done + 1, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+#endif //COPNV2_PROGRESS_H
@@ -0,0 +1,73 @@
+#include "scratch.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+
+#define SCRATCH_NAME "/copper-XXXXXX"
+
+bool scratch_map(scratch_t *s, const char *dir, size_t bytes, size_t budget) {
+    size_t dir_len = strlen(dir);
+    char *path = malloc(dir_len + sizeof(SCRATCH_NAME));
+
+    if (NULL == path) {
+        return FALSE;
+    }
+
+    memcpy(path, dir, dir_len);
+    memcpy(path + dir_len, SCRATCH_NAME, sizeof(SCRATCH_NAME));
+
+    s->data = NULL;
+    s->bytes = bytes;
+    s->touched = 0;
+    s->budget = budget;
+
+    if (-1 == (s->fd = mkstemp(path))) {
+        free(path);
+        return FALSE;
+    }
+
+    // Nobody else needs to see the file; it is reclaimed as soon as it is unmapped
+    unlink(path);
+    free(path);
+
+    // A file cannot be mapped with a size of 0
+    if (0 == bytes) {
+        bytes = 1;
+    }
+
+    if (0 != ftruncate(s->fd, (off_t) bytes) ||
+        MAP_FAILED == (s->data = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, s->fd, 0))) {
+        close(s->fd);
+        s->data = NULL;
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+void scratch_touch(scratch_t *s, size_t bytes) {
+    s->touched += bytes;
+    if (s->touched > s->budget) {
+        scratch_trim(s);
+    }
+}
+
+void scratch_trim(scratch_t *s) {
+    // The mapping is shared with the file: dropping the pages does not lose their content,
+    // it only makes them go to disk and be read back when touched again. Dirty pages stay
+    // in the page cache whatever we advise, so they are written back first, and waited for
+    msync(s->data, s->bytes, MS_SYNC);
+    madvise(s->data, s->bytes, MADV_DONTNEED);
+    posix_fadvise(s->fd, 0, 0, POSIX_FADV_DONTNEED);
+    s->touched = 0;
+}
+
+void scratch_unmap(scratch_t *s) {
+    if (NULL != s->data) {
+        munmap(s->data, s->bytes > 0 ? s->bytes : 1);
+        close(s->fd);
+        s->data = NULL;
+    }
+}
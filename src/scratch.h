@@ -0,0 +1,52 @@
+#ifndef COPNV2_SCRATCH_H
+#define COPNV2_SCRATCH_H
+
+#include <stdlib.h>
+#include "types.h"
+
+/**
+ * A zero-filled block of memory backed by an (already unlinked) file in a scratch
+ * directory. The kernel pages it in and out as needed, so it can be larger than RAM;
+ * the pages we keep resident are bounded by a budget, past which they are written back
+ * and dropped.
+ */
+typedef struct {
+    void *data;
+    size_t bytes;
+    int fd;
+    // Bytes accessed since the last trim, an over-estimate of what is resident
+    size_t touched;
+    size_t budget;
+} scratch_t;
+
+/**
+ * Map a new scratch file
+ * @param s the structure to fill
+ * @param dir the directory to create the file in
+ * @param bytes the size of the mapping
+ * @param budget how many bytes may be accessed before the resident pages are dropped
+ * @return if the mapping could be created
+ */
+bool scratch_map(scratch_t *s, const char *dir, size_t bytes, size_t budget);
+
+/**
+ * Account for bytes of the mapping that were accessed, dropping the resident pages
+ * once the budget is exceeded
+ * @param s the scratch mapping
+ * @param bytes how many bytes were accessed
+ */
+void scratch_touch(scratch_t *s, size_t bytes);
+
+/**
+ * Write back and drop all the resident pages of the mapping
+ * @param s the scratch mapping
+ */
+void scratch_trim(scratch_t *s);
+
+/**
+ * Unmap the scratch file (its storage goes away with it)
+ * @param s the scratch mapping
+ */
+void scratch_unmap(scratch_t *s);
+
+#endif //COPNV2_SCRATCH_H
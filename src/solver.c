@@ -0,0 +1,2319 @@
+#include "solver.h"
+#include <stdlib.h>
+#include <string.h>
+#include "bitset.h"
+#include "vertice_queue.h"
+#include "scratch.h"
+#include <time.h>
+#include <math.h>
+#include <pthread.h>
+
+#define WORDS(bits) (((bits) / BITSET_WIDTH) + (((bits) % BITSET_WIDTH) > 0))
+
+// The clock is read every this many pops, when there is a time budget
+#define BUDGET_CLOCK_PERIOD 1024
+
+// The vertices a table of the m4rm engine covers (2^8 or 2^4 unions). Tables serving
+// fewer rows than M4RM_WIDE_ROWS are narrow: wide ones would cost more to build than they save.
+#define M4RM_WIDE 8
+#define M4RM_NARROW 4
+#define M4RM_WIDE_ROWS 224
+
+#define ALWAYS_INLINE inline __attribute__((always_inline))
+
+/*
+ * Run an engine with k known at compile time for the usual numbers of cops, so that its
+ * loops over the coordinates are unrolled and their strides are constants; any other k
+ * takes the generic path. The engine is an ALWAYS_INLINE function taking (g, k, ...).
+ */
+#define SPECIALIZED_BY_K(engine, g, k, ...) \
+    switch (k) { \
+        case 1: return engine(g, 1, __VA_ARGS__); \
+        case 2: return engine(g, 2, __VA_ARGS__); \
+        case 3: return engine(g, 3, __VA_ARGS__); \
+        case 4: return engine(g, 4, __VA_ARGS__); \
+        default: return engine(g, k, __VA_ARGS__); \
+    }
+
+// A set of vertices, for the word engine
+typedef u64 word_t;
+
+/**
+ * Hand the strategy recorded by an engine over to the certificate, if the cops won
+ * @param cert the certificate (may be null, then there is no strategy either)
+ * @param satisfied if the cops won
+ * @param k the number of cops
+ * @param n the number of vertices
+ * @param N the number of positions
+ * @param winner the winning start position
+ * @param strategy the strategy, freed if the cops did not win
+ */
+static void certificate_fill(certificate_t *cert, bool satisfied, u8 k, u32 n, u64 N, u64 winner, u64 *strategy) {
+    if (NULL == cert) {
+        return;
+    }
+
+    if (satisfied) {
+        certificate_clear(cert);
+        cert->k = k;
+        cert->n = n;
+        cert->N = N;
+        cert->start = winner;
+        cert->strategy = strategy;
+    } else {
+        free(strategy);
+    }
+}
+
+/**
+ * Give up on a run: its storage could not be allocated
+ * @param ctx the solver context
+ * @param n the number of vertices
+ * @param k the number of cops
+ * @return FALSE, what the engine returns
+ */
+static bool refuse(solver_ctx_t *ctx, u32 n, u8 k) {
+    if (!ctx->quiet) {
+        printf("Not enough memory for %u^%u positions. Giving up.\n", n, k);
+    }
+    ctx->refused = TRUE;
+    return FALSE;
+}
+
+/**
+ * The time, for budgets
+ * @return seconds on the monotonic clock
+ */
+static double monotonic_seconds(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (double) t.tv_sec + (double) t.tv_nsec / 1e9;
+}
+
+/**
+ * Count a pop against the budgets of the graph, before doing it. The engines call this
+ * for every position they process, and give up on the run once it returns true.
+ * @param ctx the solver context
+ * @return if a budget ran out (ctx->timed_out is then set)
+ */
+static bool budget_spent(solver_ctx_t *ctx) {
+    ctx->pops++;
+
+    if ((0 != ctx->pop_budget && ctx->pops > ctx->pop_budget) ||
+        (ctx->time_budget > 0 && 0 == ctx->pops % BUDGET_CLOCK_PERIOD && monotonic_seconds() > ctx->deadline)) {
+        ctx->timed_out = TRUE;
+    }
+
+    return ctx->timed_out;
+}
+
+/**
+ * Decode a position, from the one decoded before it. The engines pop positions mostly in
+ * increasing order, and most of the time only the last coordinate moves: that is an
+ * addition instead of k divisions.
+ * @param k the number of cops
+ * @param tuple the tuple of the position at *at, updated to the one of T
+ * @param n the number of vertices
+ * @param at the position tuple holds (anything past the last position if none), updated to T
+ * @param T the position to decode
+ */
+static ALWAYS_INLINE void tuple_seek(u8 k, u32 *tuple, u32 n, u64 *at, u64 T) {
+    if (T >= *at && T - *at < n - tuple[k - 1]) {
+        tuple[k - 1] += T - *at;
+    } else {
+        int_to_tuple(k, tuple, n, T);
+    }
+    *at = T;
+}
+
+/**
+ * Allocate the strategy of a certificate, every move unset
+ * @param N the number of positions
+ * @param n the number of vertices
+ * @return the strategy (or null if allocation failed)
+ */
+static u64 *strategy_new(u64 N, u32 n) {
+    u64 *strategy = mem_alloc_array(NULL, N * n, sizeof(u64));
+    if (NULL != strategy) {
+        for (u64 i = 0; i < N * n; ++i) {
+            strategy[i] = CERT_NO_MOVE;
+        }
+    }
+    return strategy;
+}
+
+/**
+ * The robber dominance relation: v dominates u when N[u] is included in N[v], twins going
+ * to the smaller index, so that it is a strict order. A robber on u, not adjacent to the
+ * cops, can answer every cop move as one on v would, so v is in phi(T) whenever u is, at
+ * every step of the fixed point. Dropping u from phi(T) then changes neither N[phi(T)],
+ * which is all the updates read, nor whether phi(T) is empty.
+ * Restricting the inclusion to the vertices out of the cops' reach would not be sound: a
+ * robber may step next to a cop that is moving away. Robber positions are never adjacent
+ * to the cops, so excluding the cops themselves changes nothing.
+ * Pruning phi once is enough: the updates intersect phi(T) with sets N[S], which hold the
+ * vertices dominating any of theirs, so what stays in phi(T) stays undominated.
+ * @param g the graph
+ * @param arena where to take the memory from (may be null)
+ * @return n + 1 entries of WORDS(n) blocks: entry u is the set of vertices dominating u,
+ * entry n the set of dominated vertices. Null if allocation failed, or if no vertex is
+ * dominated (there is nothing to prune then).
+ */
+static BITSET_DATA_UNIT *dominators_new(graph_t *g, arena_t *arena) {
+    u32 n = g->n;
+    u32 l = WORDS(n);
+    BITSET_DATA_UNIT *dom = mem_alloc_array(arena, (size_t) (n + 1) * l, sizeof(BITSET_DATA_UNIT));
+    if (NULL == dom) {
+        return NULL;
+    }
+    memset(dom, 0, sizeof(BITSET_DATA_UNIT) * (n + 1) * l);
+
+    BITSET_DATA_UNIT *dominated = dom + (size_t) n * l;
+    bool any = FALSE;
+    for (u32 u = 0; u < n; ++u) {
+        BITSET_DATA_UNIT *row_u = g->rows[u]->parts;
+        // A vertex dominating u is in N[u]
+        for (u32 w = 0; w < l; ++w) {
+            for (BITSET_DATA_UNIT left = row_u[w]; 0 != left; left &= left - 1) {
+                u32 v = w * BITSET_WIDTH + __builtin_ctz(left);
+                if (v == u) {
+                    continue;
+                }
+                BITSET_DATA_UNIT *row_v = g->rows[v]->parts;
+                bool included = TRUE, equal = TRUE;
+                for (u32 x = 0; x < l; ++x) {
+                    included &= 0 == (row_u[x] & ~row_v[x]);
+                    equal &= row_u[x] == row_v[x];
+                }
+                if (included && (!equal || v < u)) {
+                    dom[(size_t) u * l + w] |= 1U << (v % BITSET_WIDTH);
+                    dominated[u / BITSET_WIDTH] |= 1U << (u % BITSET_WIDTH);
+                    any = TRUE;
+                }
+            }
+        }
+    }
+
+    if (!any) {
+        mem_free(arena, dom);
+        return NULL;
+    }
+    return dom;
+}
+
+/**
+ * Drop the dominated vertices of an entry of phi (see dominators_new). Each one is dominated
+ * by a vertex that stays, the relation being a strict order.
+ * @param phi_t the entry, l blocks
+ * @param dom the dominance relation
+ * @param n the number of vertices
+ * @param l the number of blocks of an entry
+ */
+static void prune_dominated(BITSET_DATA_UNIT *phi_t, const BITSET_DATA_UNIT *dom, u32 n, u32 l) {
+    const BITSET_DATA_UNIT *dominated = dom + (size_t) n * l;
+    for (u32 w = 0; w < l; ++w) {
+        for (BITSET_DATA_UNIT left = phi_t[w] & dominated[w]; 0 != left; left &= left - 1) {
+            u32 u = w * BITSET_WIDTH + __builtin_ctz(left);
+            const BITSET_DATA_UNIT *dom_u = dom + (size_t) u * l;
+            for (u32 x = 0; x < l; ++x) {
+                if (dom_u[x] & phi_t[x]) {
+                    phi_t[w] &= ~(1U << (u % BITSET_WIDTH));
+                    break;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Complete a strategy recorded on a pruned phi: the robber on a dominated vertex u is
+ * answered as on a vertex v dominating it that phi kept. Every robber move from u is a
+ * move from v, so the cops' answer to v also wins against u.
+ * @param g the graph
+ * @param k the number of cops
+ * @param N the number of positions
+ * @param strategy the strategy, N * n entries
+ * @param dom the dominance relation (see dominators_new)
+ * @param arena where to take the scratch memory from (may be null)
+ */
+static void strategy_inherit(graph_t *g, u8 k, u64 N, u64 *strategy, const BITSET_DATA_UNIT *dom, arena_t *arena) {
+    u32 n = g->n;
+    u32 l = WORDS(n);
+    const BITSET_DATA_UNIT *dominated = dom + (size_t) n * l;
+
+    u32 *tuple = mem_alloc(arena, sizeof(u32) * k);
+    memset(tuple, 0, sizeof(u32) * k);
+    // The vertices out of the cops' reach, which is where phi(T) starts
+    BITSET_DATA_UNIT *out = mem_alloc(arena, sizeof(BITSET_DATA_UNIT) * l);
+
+    for (u64 T = 0; T < N; ++T) {
+        for (u32 w = 0; w < l; ++w) {
+            out[w] = ~0U;
+            for (u8 j = 0; j < k; ++j) {
+                out[w] &= ~g->rows[tuple[j]]->parts[w];
+            }
+        }
+
+        for (u32 w = 0; w < l; ++w) {
+            for (BITSET_DATA_UNIT left = dominated[w] & out[w]; 0 != left; left &= left - 1) {
+                u32 u = w * BITSET_WIDTH + __builtin_ctz(left);
+                // Climb to a vertex no vertex of phi(T) dominates: the one phi(T) kept
+                u32 v = u;
+                bool climbed = TRUE;
+                while (climbed) {
+                    climbed = FALSE;
+                    const BITSET_DATA_UNIT *dom_v = dom + (size_t) v * l;
+                    for (u32 x = 0; x < l && !climbed; ++x) {
+                        if (dom_v[x] & out[x]) {
+                            v = x * BITSET_WIDTH + __builtin_ctz(dom_v[x] & out[x]);
+                            climbed = TRUE;
+                        }
+                    }
+                }
+                if (v != u) {
+                    strategy[(size_t) T * n + u] = strategy[(size_t) T * n + v];
+                }
+            }
+        }
+
+        i32 j = k - 1;
+        while (j >= 0 && ++tuple[j] == n) {
+            tuple[j--] = 0;
+        }
+    }
+
+    mem_free(arena, out);
+    mem_free(arena, tuple);
+}
+
+/**
+ * This is line 1 of the algorithm: phi(T) is set to the vertices outside of the closed
+ * neighbourhood of the cops on T, for every position T. Positions are walked in index order
+ * with an odometer, so consecutive positions share all but their last coordinate: the union
+ * of the rows of a prefix is computed once, and each position only adds the row of its last
+ * coordinate. This is about N (1 + 1/n + ...) row unions instead of k N.
+ * @param g the graph
+ * @param k the number of cops
+ * @param phi_parts the storage of phi, N entries of l blocks each, written in place
+ * @param l the number of blocks of an entry
+ * @param N the number of positions (n^k)
+ * @param arena where to take the scratch memory from (may be null)
+ * @param store if phi is in a scratch file, to account for the pages written (may be null)
+ * @param dom if not null, the dominance relation to prune phi with (see dominators_new)
+ */
+static void init_phi(graph_t *g, u8 k, BITSET_DATA_UNIT *phi_parts, u32 l, u64 N, arena_t *arena,
+                     scratch_t *store, const BITSET_DATA_UNIT *dom) {
+    u32 n = g->n;
+    BITSET_DATA_UNIT mask = (n % BITSET_WIDTH) ? (1U << (n % BITSET_WIDTH)) - 1U : ~0U;
+
+    u32 *digits = mem_alloc(arena, sizeof(u32) * k);
+    memset(digits, 0, sizeof(u32) * k);
+    // Level j holds the union of the rows of digits[0 .. j - 1]; level 0 is empty
+    BITSET_DATA_UNIT *levels = mem_alloc(arena, sizeof(BITSET_DATA_UNIT) * k * l);
+    memset(levels, 0, sizeof(BITSET_DATA_UNIT) * k * l);
+
+    u8 j = 0;
+    for (u64 i = 0; i < N; ++i) {
+        // Bring the levels after the digit that just moved up to date
+        for (u8 m = j + 1; m < k; ++m) {
+            BITSET_DATA_UNIT *below = levels + (size_t) (m - 1) * l;
+            BITSET_DATA_UNIT *row = g->rows[digits[m - 1]]->parts;
+            BITSET_DATA_UNIT *level = levels + (size_t) m * l;
+            for (u32 w = 0; w < l; ++w) {
+                level[w] = below[w] | row[w];
+            }
+        }
+
+        BITSET_DATA_UNIT *prefix = levels + (size_t) (k - 1) * l;
+        BITSET_DATA_UNIT *row = g->rows[digits[k - 1]]->parts;
+        BITSET_DATA_UNIT *out = phi_parts + (size_t) i * l;
+        for (u32 w = 0; w < l; ++w) {
+            out[w] = ~(prefix[w] | row[w]);
+        }
+        out[l - 1] &= mask;
+        if (NULL != dom) {
+            prune_dominated(out, dom, n, l);
+        }
+
+        if (NULL != store) {
+            scratch_touch(store, sizeof(BITSET_DATA_UNIT) * l);
+        }
+
+        // Advance the odometer; j is the most significant digit that changed
+        j = k - 1;
+        while (++digits[j] == n && j > 0) {
+            digits[j--] = 0;
+        }
+    }
+
+    mem_free(arena, levels);
+    mem_free(arena, digits);
+}
+
+/**
+ * The fixed point on a materialized tensor graph, with a worklist ordered by ctx->worklist
+ * (FIFO by default).
+ * @param g the graph
+ * @param k the cop number "target"
+ * @param ctx the solver context
+ * @return if k cops win on g
+ */
+static bool algo2_materialized(graph_t *g, u8 k, solver_ctx_t *ctx) {
+    arena_t *arena = ctx->arena;
+    certificate_t *cert = ctx->cert;
+
+    // Everything below is scratch; with an arena it is all given back at once on return
+    arena_mark_t mark;
+    if (NULL != arena) {
+        mark = arena_mark(arena);
+    }
+
+    u32 n = g->n;
+    u64 N = ipow(n, k);
+    u32 l = WORDS(n);
+
+    // The tensor graph, as lists: the neighbours of T are tensor_adj[tensor_start[T] ..
+    // tensor_start[T + 1]), the product of the closed neighbourhoods of its coordinates.
+    // That is closed^k entries where rows would take N^2 bits. They come from the lists of
+    // g, copied into a view of it (see tensor_neighbours_into).
+    graph_t view = *g;
+    u64 closed = graph_lists_in(arena, g, &view.adj_start, &view.adj);
+    u64 edges = 0;
+    u64 *tensor_start = NULL;
+    u32 *tensor_adj = NULL;
+    BITSET_DATA_UNIT *phi_parts = NULL;
+    bitset_t *phi = NULL;
+    vertice_queue_t *q = NULL;
+    u64 *strategy = NULL;
+
+    // Nothing is worth attempting if any part is missing
+    if (N > MATERIALIZED_MAX_STATES ||
+        NULL == view.adj_start || NULL == view.adj || !ipow_checked(closed, k, &edges) ||
+        NULL == (tensor_start = mem_alloc_array(arena, N + 1, sizeof(u64))) ||
+        NULL == (tensor_adj = mem_alloc_array(arena, edges, sizeof(u32))) ||
+        // All the entries of phi live in one block of memory
+        NULL == (phi_parts = mem_alloc_array(arena, N * l, sizeof(BITSET_DATA_UNIT))) ||
+        NULL == (phi = mem_alloc_array(arena, N, sizeof(bitset_t))) ||
+        NULL == (q = vertice_queue_new_policy_in(arena, N, ctx->worklist)) ||
+        // When a certificate is requested, we remember for each state (T, u) the position T'
+        // whose update removed u from phi(T). Every robber move from u was already out of
+        // phi(T') at that time, so following those moves always ends in a capture.
+        (NULL != cert && NULL == (strategy = strategy_new(N, n)))) {
+        if (NULL != arena) {
+            arena_release(arena, mark);
+        } else {
+            if (NULL != q) {
+                vertice_queue_destroy(q);
+            }
+            free(phi);
+            free(phi_parts);
+            free(tensor_adj);
+            free(tensor_start);
+            free(view.adj);
+            free(view.adj_start);
+        }
+        return refuse(ctx, n, k);
+    }
+
+    u64 built = trace_now(ctx->trace);
+    u32 tuple[k];
+    u64 decoded = N;
+    tensor_start[0] = 0;
+    for (u64 T = 0; T < N; ++T) {
+        tuple_seek(k, tuple, n, &decoded, T);
+        tensor_start[T + 1] = tensor_start[T] + tensor_neighbours_into(&view, k, tuple, tensor_adj + tensor_start[T]);
+    }
+    trace_span(ctx->trace, TRACE_TENSOR_POWER, built, n, k);
+
+    // See dominators_new
+    BITSET_DATA_UNIT *dom = ctx->dominance ? dominators_new(g, arena) : NULL;
+    init_phi(g, k, phi_parts, l, N, arena, NULL, dom);
+
+    // Reused by every iteration of the worklist
+    u32 *phi_t_vertex_set = mem_alloc(arena, sizeof(u32) * n);
+    bitset_t *phi_t_neighbourhood = new_bitset_in(arena, n);
+
+    bool satisfied = FALSE;
+    u64 winner = 0;
+    // The size of phi(t') is only needed to key the worklist
+    bool keyed = worklist_keyed(q->policy);
+    bool by_size = WORKLIST_PHI_SIZE == q->policy;
+
+    for (u64 i = 0; i < N; ++i) {
+        phi[i].parts = phi_parts + (size_t) i * l;
+        phi[i].l = l;
+        phi[i].bits = n;
+        if (keyed) {
+            // Line 1 already shrank phi(i) from all the vertices
+            u32 size = bitset_count(phi + i);
+            vertice_queue_push_keyed(q, i, by_size ? size : n - size);
+        } else {
+            vertice_queue_push(q, i);
+        }
+
+        // The cops dominate the graph from this position
+        if (!satisfied && !bitset_any(phi + i)) {
+            satisfied = TRUE;
+            winner = i;
+        }
+    }
+
+    // phi entries only shrink, so as soon as one is empty the cops win from there
+    // and there is no need to run the fixed point to convergence.
+    while (q->sz > 0 && !satisfied && !budget_spent(ctx)) {
+        // Pop (line 4)
+        u64 T = vertice_queue_pop(q);
+
+        // Prepare the data for the rest of the while loop
+        bitset_t *phi_t = phi + T;
+
+        u32 phi_t_sz = bitset_indices_into(phi_t, phi_t_vertex_set);
+        neighbourhood_into(g, phi_t_vertex_set, phi_t_sz, phi_t_neighbourhood);
+
+        u64 neigh_sz = tensor_start[T + 1] - tensor_start[T];
+        u32 *neighbours_indices = tensor_adj + tensor_start[T];
+
+        for (u64 i = 0; i < neigh_sz && !satisfied; ++i) {
+            u32 t_prime = neighbours_indices[i];
+            bitset_t *phi_t_prime = phi + t_prime;
+
+            if (NULL != strategy) {
+                // Record the robber positions about to be removed from phi(t')
+                for (u32 u = 0; u < n; ++u) {
+                    if (bitset_set(phi_t_prime, u, READ_ONLY) && !bitset_set(phi_t_neighbourhood, u, READ_ONLY)) {
+                        strategy[(size_t) t_prime * n + u] = T;
+                    }
+                }
+            }
+
+            u32 before = keyed ? bitset_count(phi_t_prime) : 0;
+            if (bitset_and(phi_t_prime, phi_t_neighbourhood)) {
+                if (!bitset_any(phi_t_prime)) {
+                    satisfied = TRUE;
+                    winner = t_prime;
+                } else if (keyed) {
+                    u32 after = bitset_count(phi_t_prime);
+                    vertice_queue_push_keyed(q, t_prime, by_size ? after : before - after);
+                } else {
+                    vertice_queue_push(q, t_prime);
+                }
+            }
+        }
+    }
+
+    if (satisfied && NULL != strategy && NULL != dom) {
+        strategy_inherit(g, k, N, strategy, dom, arena);
+    }
+
+    if (NULL != arena) {
+        arena_release(arena, mark);
+    } else {
+        free(dom);
+        free(phi_t_vertex_set);
+        bitset_destroy(phi_t_neighbourhood);
+        vertice_queue_destroy(q);
+        free(phi);
+        free(phi_parts);
+        free(tensor_adj);
+        free(tensor_start);
+        free(view.adj);
+        free(view.adj_start);
+    }
+
+    certificate_fill(cert, satisfied, k, n, N, winner, strategy);
+
+    return satisfied;
+}
+
+/**
+ * The fixed point without the tensor graph: the neighbours of a position are enumerated
+ * as the product of the closed neighbourhoods of its coordinates. Instead of a FIFO, the
+ * positions to process are kept in a bitset and swept in index order, so consecutive
+ * positions touch mostly the same entries of phi. phi and that bitset are in scratch
+ * files when a directory is given, in memory otherwise.
+ * @param g the graph
+ * @param k the cop number "target"
+ * @param ctx the solver context
+ * @param dir the scratch directory (null to stay in memory)
+ * @return if k cops win on g
+ */
+static ALWAYS_INLINE bool algo2_sweep_k(graph_t *g, u8 k, solver_ctx_t *ctx, const char *dir) {
+    arena_t *arena = ctx->arena;
+    arena_mark_t mark;
+    if (NULL != arena) {
+        mark = arena_mark(arena);
+    }
+
+    u32 n = g->n;
+    u64 N = ipow(n, k);
+    u32 l = WORDS(n);
+
+    // See algo2_materialized
+    u64 *strategy = NULL;
+    if (NULL != ctx->cert && NULL == (strategy = strategy_new(N, n))) {
+        return refuse(ctx, n, k);
+    }
+    u64 winner = 0;
+
+    BITSET_DATA_UNIT *phi_parts, *dirty;
+    scratch_t phi_store, dirty_store;
+    scratch_t *store = NULL;
+
+    if (NULL != dir) {
+        if (!scratch_map(&phi_store, dir, sizeof(BITSET_DATA_UNIT) * l * N, ctx->resident_budget)) {
+            if (!ctx->quiet) {
+                printf("Failed to map scratch storage in %s.\n", dir);
+            }
+            free(strategy);
+            return refuse(ctx, n, k);
+        }
+        // The bitset is n times smaller than phi; it is not worth trimming
+        if (!scratch_map(&dirty_store, dir, sizeof(BITSET_DATA_UNIT) * WORDS(N), (size_t) -1)) {
+            if (!ctx->quiet) {
+                printf("Failed to map scratch storage in %s.\n", dir);
+            }
+            scratch_unmap(&phi_store);
+            free(strategy);
+            return refuse(ctx, n, k);
+        }
+        store = &phi_store;
+        phi_parts = phi_store.data;
+        dirty = dirty_store.data;
+    } else {
+        phi_parts = mem_alloc_array(arena, N * l, sizeof(BITSET_DATA_UNIT));
+        dirty = mem_alloc_array(arena, WORDS(N), sizeof(BITSET_DATA_UNIT));
+        if (NULL == phi_parts || NULL == dirty) {
+            if (NULL != arena) {
+                arena_release(arena, mark);
+            } else {
+                free(phi_parts);
+                free(dirty);
+            }
+            free(strategy);
+            return refuse(ctx, n, k);
+        }
+    }
+
+    // See dominators_new
+    BITSET_DATA_UNIT *dom = ctx->dominance ? dominators_new(g, arena) : NULL;
+    init_phi(g, k, phi_parts, l, N, arena, store, dom);
+
+    // Everything needs processing once
+    for (u64 w = 0; w < WORDS(N); ++w) {
+        dirty[w] = ~0U;
+    }
+    if (N % BITSET_WIDTH) {
+        dirty[WORDS(N) - 1] = (1U << (N % BITSET_WIDTH)) - 1U;
+    }
+
+    // Closed neighbourhoods of g, as lists
+    u64 *adj_start;
+    u32 *adj;
+    graph_lists_in(arena, g, &adj_start, &adj);
+
+    // Weight of each coordinate in the encoding of a position. These are on the stack, with
+    // a constant size once k is specialized.
+    u64 weight[k];
+    for (u8 j = 0; j < k; ++j) {
+        weight[j] = ipow(n, k - j - 1);
+    }
+
+    // The popped position (decoded is N until one is), and the odometer over its neighbours
+    u32 tuple[k];
+    u64 decoded = N;
+    u64 pos[k];
+    // partial[j] is the encoding of the first j coordinates of the current neighbour
+    u64 partial[k + 1];
+    u32 *phi_t_vertex_set = mem_alloc(arena, sizeof(u32) * n);
+    bitset_t *phi_t_neighbourhood = new_bitset_in(arena, n);
+    BITSET_DATA_UNIT *nb = phi_t_neighbourhood->parts;
+
+    bool satisfied = FALSE;
+    bool swept_dirty = TRUE;
+
+    while (swept_dirty && !satisfied && !ctx->timed_out) {
+        swept_dirty = FALSE;
+
+        for (u64 w = 0; w < WORDS(N) && !satisfied && !ctx->timed_out; ++w) {
+            BITSET_DATA_UNIT word;
+            // Positions of this word may get dirty again while we process it
+            while (0 != (word = dirty[w]) && !satisfied) {
+                u64 T = w * BITSET_WIDTH + __builtin_ctz(word);
+                dirty[w] &= ~(1U << (T % BITSET_WIDTH));
+                swept_dirty = TRUE;
+                if (budget_spent(ctx)) {
+                    break;
+                }
+
+                bitset_t phi_t = {phi_parts + (size_t) T * l, l, n};
+                if (!bitset_any(&phi_t)) {
+                    satisfied = TRUE;
+                    winner = T;
+                    break;
+                }
+
+                u32 phi_t_sz = bitset_indices_into(&phi_t, phi_t_vertex_set);
+                neighbourhood_into(g, phi_t_vertex_set, phi_t_sz, phi_t_neighbourhood);
+                tuple_seek(k, tuple, n, &decoded, T);
+
+                partial[0] = 0;
+                for (u8 j = 0; j < k; ++j) {
+                    pos[j] = adj_start[tuple[j]];
+                    partial[j + 1] = partial[j] + adj[pos[j]] * weight[j];
+                }
+
+                size_t touched = 1;
+                while (TRUE) {
+                    u64 t_prime = partial[k];
+                    BITSET_DATA_UNIT *phi_t_prime = phi_parts + (size_t) t_prime * l;
+                    BITSET_DATA_UNIT change = 0, left = 0;
+
+                    if (NULL != strategy) {
+                        bitset_t view = {phi_t_prime, l, n};
+                        for (u32 u = 0; u < n; ++u) {
+                            if (bitset_set(&view, u, READ_ONLY) && !bitset_set(phi_t_neighbourhood, u, READ_ONLY)) {
+                                strategy[(size_t) t_prime * n + u] = T;
+                            }
+                        }
+                    }
+
+                    for (u32 i = 0; i < l; ++i) {
+                        BITSET_DATA_UNIT old = phi_t_prime[i];
+                        phi_t_prime[i] = old & nb[i];
+                        change |= old ^ phi_t_prime[i];
+                        left |= phi_t_prime[i];
+                    }
+                    touched++;
+
+                    if (change) {
+                        if (!left) {
+                            satisfied = TRUE;
+                            winner = t_prime;
+                            break;
+                        }
+                        dirty[t_prime / BITSET_WIDTH] |= 1U << (t_prime % BITSET_WIDTH);
+                    }
+
+                    // Next neighbour: advance the odometer over the coordinates' neighbourhoods
+                    i32 j = k - 1;
+                    while (j >= 0 && ++pos[j] == adj_start[tuple[j] + 1]) {
+                        pos[j] = adj_start[tuple[j]];
+                        j--;
+                    }
+                    if (j < 0) {
+                        break;
+                    }
+                    for (; j < k; ++j) {
+                        partial[j + 1] = partial[j] + adj[pos[j]] * weight[j];
+                    }
+                }
+
+                if (NULL != store) {
+                    scratch_touch(store, touched * l * sizeof(BITSET_DATA_UNIT));
+                }
+            }
+        }
+    }
+
+    if (NULL != store) {
+        scratch_unmap(&phi_store);
+        scratch_unmap(&dirty_store);
+    }
+
+    if (satisfied && NULL != strategy && NULL != dom) {
+        strategy_inherit(g, k, N, strategy, dom, arena);
+    }
+
+    if (NULL != arena) {
+        arena_release(arena, mark);
+    } else {
+        if (NULL == store) {
+            free(phi_parts);
+            free(dirty);
+        }
+        free(dom);
+        free(adj_start);
+        free(adj);
+        free(phi_t_vertex_set);
+        bitset_destroy(phi_t_neighbourhood);
+    }
+
+    certificate_fill(ctx->cert, satisfied, k, n, N, winner, strategy);
+
+    return satisfied;
+}
+
+/**
+ * algo2_sweep_k, specialized for the usual k
+ */
+static bool algo2_sweep(graph_t *g, u8 k, solver_ctx_t *ctx, const char *dir) {
+    SPECIALIZED_BY_K(algo2_sweep_k, g, k, ctx, dir);
+}
+
+/**
+ * The sweep (see algo2_sweep) for graphs of at most WORD_BITS vertices. A set of vertices
+ * is a single word: rows of g and entries of phi are plain arrays of words, unions and
+ * intersections are single instructions, and nothing is allocated per position.
+ * @param g the graph (n <= WORD_BITS)
+ * @param k the cop number "target"
+ * @param ctx the solver context
+ * @return if k cops win on g
+ */
+static ALWAYS_INLINE bool algo2_word_k(graph_t *g, u8 k, solver_ctx_t *ctx) {
+    arena_t *arena = ctx->arena;
+    arena_mark_t mark;
+    if (NULL != arena) {
+        mark = arena_mark(arena);
+    }
+
+    u32 n = g->n;
+    u64 N = ipow(n, k);
+    u64 dirty_words = (N + WORD_BITS - 1) / WORD_BITS;
+    word_t full = n == WORD_BITS ? ~(word_t) 0 : ((word_t) 1 << n) - 1;
+
+    // Rows, closed neighbourhoods as lists, and the odometer state all fit on the stack
+    word_t rows[WORD_BITS];
+    u32 adj[WORD_BITS * WORD_BITS];
+    u32 adj_start[WORD_BITS + 1];
+    adj_start[0] = 0;
+    for (u32 v = 0; v < n; ++v) {
+        BITSET_DATA_UNIT *parts = g->rows[v]->parts;
+        rows[v] = 0;
+        for (u32 w = 0; w < g->rows[v]->l; ++w) {
+            rows[v] |= (word_t) parts[w] << (w * BITSET_WIDTH);
+        }
+        adj_start[v + 1] = adj_start[v] + bitset_indices_into(g->rows[v], adj + adj_start[v]);
+    }
+
+    // The popped position (decoded is N until one is), and the odometer over its neighbours
+    u64 weight[k], partial[k + 1], decoded = N;
+    u32 tuple[k], pos[k];
+    for (u8 j = 0; j < k; ++j) {
+        weight[j] = ipow(n, k - j - 1);
+    }
+
+    // See algo2_materialized
+    u64 *strategy = NULL;
+    word_t *phi = mem_alloc_array(arena, N, sizeof(word_t));
+    word_t *dirty = mem_alloc_array(arena, dirty_words, sizeof(word_t));
+
+    if (NULL == phi || NULL == dirty || (NULL != ctx->cert && NULL == (strategy = strategy_new(N, n)))) {
+        if (NULL != arena) {
+            arena_release(arena, mark);
+        } else {
+            free(phi);
+            free(dirty);
+        }
+        return refuse(ctx, n, k);
+    }
+
+    // See dominators_new; dom_words[u] is the set of vertices dominating u
+    BITSET_DATA_UNIT *dom = ctx->dominance ? dominators_new(g, arena) : NULL;
+    word_t dom_words[WORD_BITS], dominated = 0;
+    if (NULL != dom) {
+        u32 l = WORDS(n);
+        for (u32 u = 0; u <= n; ++u) {
+            word_t set = 0;
+            for (u32 w = 0; w < l; ++w) {
+                set |= (word_t) dom[(size_t) u * l + w] << (w * BITSET_WIDTH);
+            }
+            if (u < n) {
+                dom_words[u] = set;
+            } else {
+                dominated = set;
+            }
+        }
+    }
+
+    // Line 1, with the same prefix-shared odometer as init_phi
+    word_t levels[k];
+    levels[0] = 0;
+    for (u8 j = 0; j < k; ++j) {
+        tuple[j] = 0;
+    }
+    u8 moved = 0;
+    for (u64 i = 0; i < N; ++i) {
+        for (u8 m = moved + 1; m < k; ++m) {
+            levels[m] = levels[m - 1] | rows[tuple[m - 1]];
+        }
+        phi[i] = ~(levels[k - 1] | rows[tuple[k - 1]]) & full;
+        for (word_t left = phi[i] & dominated; 0 != left; left &= left - 1) {
+            u32 u = __builtin_ctzll(left);
+            if (dom_words[u] & phi[i]) {
+                phi[i] &= ~((word_t) 1 << u);
+            }
+        }
+
+        moved = k - 1;
+        while (++tuple[moved] == n && moved > 0) {
+            tuple[moved--] = 0;
+        }
+    }
+
+    // Everything needs processing once
+    for (u64 w = 0; w < dirty_words; ++w) {
+        dirty[w] = ~(word_t) 0;
+    }
+    if (N % WORD_BITS) {
+        dirty[dirty_words - 1] = ((word_t) 1 << (N % WORD_BITS)) - 1;
+    }
+
+    bool satisfied = FALSE;
+    bool swept_dirty = TRUE;
+    u64 winner = 0;
+
+    while (swept_dirty && !satisfied && !ctx->timed_out) {
+        swept_dirty = FALSE;
+
+        for (u64 w = 0; w < dirty_words && !satisfied && !ctx->timed_out; ++w) {
+            word_t word;
+            // Positions of this word may get dirty again while we process it
+            while (0 != (word = dirty[w]) && !satisfied) {
+                u64 T = w * WORD_BITS + __builtin_ctzll(word);
+                dirty[w] &= dirty[w] - 1;
+                swept_dirty = TRUE;
+                if (budget_spent(ctx)) {
+                    break;
+                }
+
+                if (0 == phi[T]) {
+                    satisfied = TRUE;
+                    winner = T;
+                    break;
+                }
+
+                // The robber positions still safe after the robber moves from phi(T)
+                word_t nb = 0;
+                for (word_t left = phi[T]; 0 != left; left &= left - 1) {
+                    nb |= rows[__builtin_ctzll(left)];
+                }
+
+                tuple_seek(k, tuple, n, &decoded, T);
+                partial[0] = 0;
+                for (u8 j = 0; j < k; ++j) {
+                    pos[j] = adj_start[tuple[j]];
+                    partial[j + 1] = partial[j] + adj[pos[j]] * weight[j];
+                }
+
+                while (TRUE) {
+                    u64 t_prime = partial[k];
+                    word_t old = phi[t_prime];
+                    word_t kept = old & nb;
+
+                    if (kept != old) {
+                        if (NULL != strategy) {
+                            for (word_t removed = old & ~nb; 0 != removed; removed &= removed - 1) {
+                                strategy[t_prime * n + __builtin_ctzll(removed)] = T;
+                            }
+                        }
+
+                        phi[t_prime] = kept;
+                        if (0 == kept) {
+                            satisfied = TRUE;
+                            winner = t_prime;
+                            break;
+                        }
+                        dirty[t_prime / WORD_BITS] |= (word_t) 1 << (t_prime % WORD_BITS);
+                    }
+
+                    // Next neighbour: advance the odometer over the coordinates' neighbourhoods
+                    i32 j = k - 1;
+                    while (j >= 0 && ++pos[j] == adj_start[tuple[j] + 1]) {
+                        pos[j] = adj_start[tuple[j]];
+                        j--;
+                    }
+                    if (j < 0) {
+                        break;
+                    }
+                    for (; j < k; ++j) {
+                        partial[j + 1] = partial[j] + adj[pos[j]] * weight[j];
+                    }
+                }
+            }
+        }
+    }
+
+    if (satisfied && NULL != strategy && NULL != dom) {
+        strategy_inherit(g, k, N, strategy, dom, arena);
+    }
+
+    if (NULL != arena) {
+        arena_release(arena, mark);
+    } else {
+        free(dom);
+        free(phi);
+        free(dirty);
+    }
+
+    certificate_fill(ctx->cert, satisfied, k, n, N, winner, strategy);
+
+    return satisfied;
+}
+
+/**
+ * algo2_word_k, specialized for the usual k
+ */
+static bool algo2_word(graph_t *g, u8 k, solver_ctx_t *ctx) {
+    SPECIALIZED_BY_K(algo2_word_k, g, k, ctx);
+}
+
+/**
+ * The sweep (see algo2_sweep), propagating what changed instead of recomputing it. For each
+ * position T and vertex v, count[T][v] is the number of members of phi(T) in the closed
+ * neighbourhood of v: v is in N[phi(T)] while it is not zero. Removing u from phi(T)
+ * decrements the counts of N[u], and the vertices whose count drops to zero are all that
+ * leaves N[phi(T)]. They are gathered in delta(T), and processing T only takes delta(T) out
+ * of the phi of its tensor neighbours: the first time, delta(T) is everything outside of
+ * N[phi(T)]. Positions whose phi lost a vertex without N[phi(T)] shrinking are never
+ * processed again, and the work is proportional to the removals rather than to the pops.
+ * @param g the graph (closed degrees of at most COUNTER_MAX_DEGREE)
+ * @param k the cop number "target"
+ * @param ctx the solver context
+ * @return if k cops win on g
+ */
+static bool algo2_delta(graph_t *g, u8 k, solver_ctx_t *ctx) {
+    arena_t *arena = ctx->arena;
+    arena_mark_t mark;
+    if (NULL != arena) {
+        mark = arena_mark(arena);
+    }
+
+    u32 n = g->n;
+    u64 N = ipow(n, k);
+    u32 l = WORDS(n);
+
+    // See algo2_materialized
+    u64 *strategy = NULL;
+    BITSET_DATA_UNIT *phi_parts = mem_alloc_array(arena, N * l, sizeof(BITSET_DATA_UNIT));
+    BITSET_DATA_UNIT *delta = mem_alloc_array(arena, N * l, sizeof(BITSET_DATA_UNIT));
+    BITSET_DATA_UNIT *dirty = mem_alloc_array(arena, WORDS(N), sizeof(BITSET_DATA_UNIT));
+    u8 *count = mem_alloc_array(arena, N, n);
+
+    if (NULL == phi_parts || NULL == delta || NULL == dirty || NULL == count ||
+        (NULL != ctx->cert && NULL == (strategy = strategy_new(N, n)))) {
+        if (NULL != arena) {
+            arena_release(arena, mark);
+        } else {
+            free(phi_parts);
+            free(delta);
+            free(dirty);
+            free(count);
+        }
+        return refuse(ctx, n, k);
+    }
+
+    // See dominators_new
+    BITSET_DATA_UNIT *dom = ctx->dominance ? dominators_new(g, arena) : NULL;
+    init_phi(g, k, phi_parts, l, N, arena, NULL, dom);
+
+    // Closed neighbourhoods of g, as lists
+    u64 *adj_start;
+    u32 *adj;
+    graph_lists_in(arena, g, &adj_start, &adj);
+
+    u64 *weight = mem_alloc(arena, sizeof(u64) * k);
+    for (u8 j = 0; j < k; ++j) {
+        weight[j] = ipow(n, k - j - 1);
+    }
+    u32 *tuple = mem_alloc(arena, sizeof(u32) * k);
+    u64 *pos = mem_alloc(arena, sizeof(u64) * k);
+    u64 *partial = mem_alloc(arena, sizeof(u64) * (k + 1));
+    // The position tuple holds, N if none
+    u64 decoded = N;
+
+    bool satisfied = FALSE;
+    u64 winner = 0;
+
+    // The counts, and the first delta of every position: what N[phi(T)] leaves out
+    memset(count, 0, (size_t) N * n);
+    for (u64 T = 0; T < N && !satisfied; ++T) {
+        BITSET_DATA_UNIT *phi_t = phi_parts + (size_t) T * l;
+        BITSET_DATA_UNIT *delta_t = delta + (size_t) T * l;
+        u8 *count_t = count + (size_t) T * n;
+        BITSET_DATA_UNIT any = 0;
+
+        for (u32 w = 0; w < l; ++w) {
+            any |= phi_t[w];
+            for (BITSET_DATA_UNIT left = phi_t[w]; 0 != left; left &= left - 1) {
+                u32 u = w * BITSET_WIDTH + __builtin_ctz(left);
+                for (u64 a = adj_start[u]; a < adj_start[u + 1]; ++a) {
+                    count_t[adj[a]]++;
+                }
+            }
+        }
+
+        if (0 == any) {
+            satisfied = TRUE;
+            winner = T;
+        }
+
+        memset(delta_t, 0, sizeof(BITSET_DATA_UNIT) * l);
+        for (u32 v = 0; v < n; ++v) {
+            if (0 == count_t[v]) {
+                delta_t[v / BITSET_WIDTH] |= 1U << (v % BITSET_WIDTH);
+            }
+        }
+    }
+
+    // Everything needs processing once
+    for (u64 w = 0; w < WORDS(N); ++w) {
+        dirty[w] = ~0U;
+    }
+    if (N % BITSET_WIDTH) {
+        dirty[WORDS(N) - 1] = (1U << (N % BITSET_WIDTH)) - 1U;
+    }
+
+    // delta(T), copied out since processing T may grow it again
+    BITSET_DATA_UNIT *d = mem_alloc(arena, sizeof(BITSET_DATA_UNIT) * l);
+    bool swept_dirty = TRUE;
+
+    while (swept_dirty && !satisfied && !ctx->timed_out) {
+        swept_dirty = FALSE;
+
+        for (u64 w = 0; w < WORDS(N) && !satisfied && !ctx->timed_out; ++w) {
+            BITSET_DATA_UNIT word;
+            // Positions of this word may get dirty again while we process it
+            while (0 != (word = dirty[w]) && !satisfied) {
+                u64 T = w * BITSET_WIDTH + __builtin_ctz(word);
+                dirty[w] &= ~(1U << (T % BITSET_WIDTH));
+                swept_dirty = TRUE;
+                if (budget_spent(ctx)) {
+                    break;
+                }
+
+                BITSET_DATA_UNIT *delta_t = delta + (size_t) T * l;
+                BITSET_DATA_UNIT any = 0;
+                for (u32 i = 0; i < l; ++i) {
+                    any |= (d[i] = delta_t[i]);
+                    delta_t[i] = 0;
+                }
+                if (0 == any) {
+                    continue;
+                }
+
+                tuple_seek(k, tuple, n, &decoded, T);
+                partial[0] = 0;
+                for (u8 j = 0; j < k; ++j) {
+                    pos[j] = adj_start[tuple[j]];
+                    partial[j + 1] = partial[j] + adj[pos[j]] * weight[j];
+                }
+
+                while (TRUE) {
+                    u64 t_prime = partial[k];
+                    BITSET_DATA_UNIT *phi_t_prime = phi_parts + (size_t) t_prime * l;
+                    BITSET_DATA_UNIT removed_any = 0;
+
+                    for (u32 i = 0; i < l; ++i) {
+                        removed_any |= phi_t_prime[i] & d[i];
+                    }
+
+                    if (removed_any) {
+                        BITSET_DATA_UNIT *delta_t_prime = delta + (size_t) t_prime * l;
+                        u8 *count_t_prime = count + (size_t) t_prime * n;
+                        BITSET_DATA_UNIT left = 0;
+                        bool grown = FALSE;
+
+                        for (u32 i = 0; i < l; ++i) {
+                            BITSET_DATA_UNIT removed = phi_t_prime[i] & d[i];
+                            phi_t_prime[i] &= ~d[i];
+                            left |= phi_t_prime[i];
+
+                            for (; 0 != removed; removed &= removed - 1) {
+                                u32 u = i * BITSET_WIDTH + __builtin_ctz(removed);
+                                if (NULL != strategy) {
+                                    strategy[(size_t) t_prime * n + u] = T;
+                                }
+                                // u no longer dominates its closed neighbourhood from t'
+                                for (u64 a = adj_start[u]; a < adj_start[u + 1]; ++a) {
+                                    u32 v = adj[a];
+                                    if (0 == --count_t_prime[v]) {
+                                        delta_t_prime[v / BITSET_WIDTH] |= 1U << (v % BITSET_WIDTH);
+                                        grown = TRUE;
+                                    }
+                                }
+                            }
+                        }
+
+                        if (!left) {
+                            satisfied = TRUE;
+                            winner = t_prime;
+                            break;
+                        }
+                        if (grown) {
+                            dirty[t_prime / BITSET_WIDTH] |= 1U << (t_prime % BITSET_WIDTH);
+                        }
+                    }
+
+                    // Next neighbour: advance the odometer over the coordinates' neighbourhoods
+                    i32 j = k - 1;
+                    while (j >= 0 && ++pos[j] == adj_start[tuple[j] + 1]) {
+                        pos[j] = adj_start[tuple[j]];
+                        j--;
+                    }
+                    if (j < 0) {
+                        break;
+                    }
+                    for (; j < k; ++j) {
+                        partial[j + 1] = partial[j] + adj[pos[j]] * weight[j];
+                    }
+                }
+            }
+        }
+    }
+
+    if (satisfied && NULL != strategy && NULL != dom) {
+        strategy_inherit(g, k, N, strategy, dom, arena);
+    }
+
+    if (NULL != arena) {
+        arena_release(arena, mark);
+    } else {
+        free(dom);
+        free(phi_parts);
+        free(delta);
+        free(dirty);
+        free(count);
+        free(adj_start);
+        free(adj);
+        free(weight);
+        free(tuple);
+        free(pos);
+        free(partial);
+        free(d);
+    }
+
+    certificate_fill(ctx->cert, satisfied, k, n, N, winner, strategy);
+
+    return satisfied;
+}
+
+/**
+ * Solve the game by backward induction on its explicit states, instead of algorithm 2.
+ * A state is the cops on T and the robber on r, with the cops or the robber to move:
+ *  - cops to move, (T, r) is won if a cop can step on r, or if the cops can move to some
+ *    T' where the robber to move on r is lost;
+ *  - robber to move, (T', r) is won if a cop is on r, or if every robber move to r' in
+ *    N[r] leads to a won (T', r') with the cops to move.
+ * The cop-to-move states not won yet are exactly phi: phi(T) starts as the vertices out of
+ * N[T], as in algorithm 2. Each robber-to-move state keeps a counter of the escape moves
+ * it has left, |N[r] \cap phi(T')|. A cop-to-move state that is won decrements the counters
+ * of its robber predecessors; a counter that drops to zero wins its robber state, which
+ * wins the cop-to-move states of the positions next to T'. Every state and every move of
+ * the game graph is handled at most once, so the cost is linear in its size.
+ * @param g the graph (closed degrees of at most COUNTER_MAX_DEGREE)
+ * @param k the cop number "target"
+ * @param ctx the solver context
+ * @return if k cops win on g
+ */
+static bool retrograde(graph_t *g, u8 k, solver_ctx_t *ctx) {
+    arena_t *arena = ctx->arena;
+    arena_mark_t mark;
+    if (NULL != arena) {
+        mark = arena_mark(arena);
+    }
+
+    u32 n = g->n;
+    u64 N = ipow(n, k);
+    u32 l = WORDS(n);
+    u64 S = N * n;
+
+    // See algo2_materialized: the move of each cop-to-move state won
+    u64 *strategy = NULL;
+    BITSET_DATA_UNIT *phi_parts = mem_alloc_array(arena, N * l, sizeof(BITSET_DATA_UNIT));
+    // Robber-to-move states, T * n + r: the escape moves left
+    u8 *count = mem_alloc_array(arena, N, n);
+    // States won whose predecessors are not updated yet: robber to move, then cops to move
+    BITSET_DATA_UNIT *robber_won = mem_alloc_array(arena, WORDS(S), sizeof(BITSET_DATA_UNIT));
+    BITSET_DATA_UNIT *cops_won = mem_alloc_array(arena, WORDS(S), sizeof(BITSET_DATA_UNIT));
+
+    if (NULL == phi_parts || NULL == count || NULL == robber_won || NULL == cops_won ||
+        (NULL != ctx->cert && NULL == (strategy = strategy_new(N, n)))) {
+        if (NULL != arena) {
+            arena_release(arena, mark);
+        } else {
+            free(phi_parts);
+            free(count);
+            free(robber_won);
+            free(cops_won);
+        }
+        return refuse(ctx, n, k);
+    }
+
+    // Not pruned: the counters are of every escape move
+    init_phi(g, k, phi_parts, l, N, arena, NULL, NULL);
+    memset(robber_won, 0, sizeof(BITSET_DATA_UNIT) * WORDS(S));
+    memset(cops_won, 0, sizeof(BITSET_DATA_UNIT) * WORDS(S));
+
+    // Closed neighbourhoods of g, as lists
+    u64 *adj_start;
+    u32 *adj;
+    graph_lists_in(arena, g, &adj_start, &adj);
+
+    u64 *weight = mem_alloc(arena, sizeof(u64) * k);
+    for (u8 j = 0; j < k; ++j) {
+        weight[j] = ipow(n, k - j - 1);
+    }
+    u32 *tuple = mem_alloc(arena, sizeof(u32) * k);
+    u64 *pos = mem_alloc(arena, sizeof(u64) * k);
+    u64 *partial = mem_alloc(arena, sizeof(u64) * (k + 1));
+    // The vertices the cops stand on, at the position tuple holds
+    BITSET_DATA_UNIT *cops = mem_alloc(arena, sizeof(BITSET_DATA_UNIT) * l);
+
+    bool satisfied = FALSE;
+    u64 winner = 0;
+
+    // The escape moves of every robber-to-move state. Those with none left (and no cop
+    // on the robber, whose predecessors are won already) are won from the start.
+    memset(tuple, 0, sizeof(u32) * k);
+    for (u64 T = 0; T < N && !satisfied; ++T) {
+        BITSET_DATA_UNIT *phi_t = phi_parts + (size_t) T * l;
+        u8 *count_t = count + (size_t) T * n;
+        BITSET_DATA_UNIT any = 0;
+
+        memset(count_t, 0, n);
+        for (u32 w = 0; w < l; ++w) {
+            any |= phi_t[w];
+            for (BITSET_DATA_UNIT left = phi_t[w]; 0 != left; left &= left - 1) {
+                u32 r = w * BITSET_WIDTH + __builtin_ctz(left);
+                for (u64 a = adj_start[r]; a < adj_start[r + 1]; ++a) {
+                    count_t[adj[a]]++;
+                }
+            }
+        }
+
+        if (0 == any) {
+            satisfied = TRUE;
+            winner = T;
+        }
+
+        memset(cops, 0, sizeof(BITSET_DATA_UNIT) * l);
+        for (u8 j = 0; j < k; ++j) {
+            cops[tuple[j] / BITSET_WIDTH] |= 1U << (tuple[j] % BITSET_WIDTH);
+        }
+        for (u32 r = 0; r < n; ++r) {
+            if (0 == count_t[r] && !(cops[r / BITSET_WIDTH] & (1U << (r % BITSET_WIDTH)))) {
+                u64 s = T * n + r;
+                robber_won[s / BITSET_WIDTH] |= 1U << (s % BITSET_WIDTH);
+            }
+        }
+
+        i32 j = k - 1;
+        while (j >= 0 && ++tuple[j] == n) {
+            tuple[j--] = 0;
+        }
+    }
+
+    // The position tuple and cops are for, N if none
+    u64 decoded = N;
+    bool progress = TRUE;
+
+    while (progress && !satisfied && !ctx->timed_out) {
+        progress = FALSE;
+
+        // Robber states out of escape moves: the cops next to T' win against the robber on r
+        for (u64 w = 0; w < WORDS(S) && !satisfied && !ctx->timed_out; ++w) {
+            BITSET_DATA_UNIT word;
+            while (0 != (word = robber_won[w]) && !satisfied) {
+                u64 s = w * BITSET_WIDTH + __builtin_ctz(word);
+                robber_won[w] &= word - 1;
+                progress = TRUE;
+                if (budget_spent(ctx)) {
+                    break;
+                }
+
+                u64 T = s / n;
+                u32 r = s % n;
+                BITSET_DATA_UNIT bit = 1U << (r % BITSET_WIDTH);
+                if (T != decoded) {
+                    tuple_seek(k, tuple, n, &decoded, T);
+                    memset(cops, 0, sizeof(BITSET_DATA_UNIT) * l);
+                    for (u8 j = 0; j < k; ++j) {
+                        cops[tuple[j] / BITSET_WIDTH] |= 1U << (tuple[j] % BITSET_WIDTH);
+                    }
+                }
+
+                partial[0] = 0;
+                for (u8 j = 0; j < k; ++j) {
+                    pos[j] = adj_start[tuple[j]];
+                    partial[j + 1] = partial[j] + adj[pos[j]] * weight[j];
+                }
+
+                while (TRUE) {
+                    u64 t_prime = partial[k];
+                    BITSET_DATA_UNIT *phi_t_prime = phi_parts + (size_t) t_prime * l;
+
+                    if (phi_t_prime[r / BITSET_WIDTH] & bit) {
+                        phi_t_prime[r / BITSET_WIDTH] &= ~bit;
+                        if (NULL != strategy) {
+                            strategy[(size_t) t_prime * n + r] = T;
+                        }
+
+                        BITSET_DATA_UNIT any = 0;
+                        for (u32 i = 0; i < l; ++i) {
+                            any |= phi_t_prime[i];
+                        }
+                        if (0 == any) {
+                            satisfied = TRUE;
+                            winner = t_prime;
+                            break;
+                        }
+
+                        u64 c = t_prime * n + r;
+                        cops_won[c / BITSET_WIDTH] |= 1U << (c % BITSET_WIDTH);
+                    }
+
+                    // Next neighbour: advance the odometer over the coordinates' neighbourhoods
+                    i32 j = k - 1;
+                    while (j >= 0 && ++pos[j] == adj_start[tuple[j] + 1]) {
+                        pos[j] = adj_start[tuple[j]];
+                        j--;
+                    }
+                    if (j < 0) {
+                        break;
+                    }
+                    for (; j < k; ++j) {
+                        partial[j + 1] = partial[j] + adj[pos[j]] * weight[j];
+                    }
+                }
+            }
+        }
+
+        // Cop states just won: every robber move into them is one escape move less
+        for (u64 w = 0; w < WORDS(S) && !satisfied && !ctx->timed_out; ++w) {
+            BITSET_DATA_UNIT word;
+            while (0 != (word = cops_won[w])) {
+                u64 s = w * BITSET_WIDTH + __builtin_ctz(word);
+                cops_won[w] &= word - 1;
+                progress = TRUE;
+                if (budget_spent(ctx)) {
+                    break;
+                }
+
+                u64 T = s / n;
+                u32 r_prime = s % n;
+                if (T != decoded) {
+                    tuple_seek(k, tuple, n, &decoded, T);
+                    memset(cops, 0, sizeof(BITSET_DATA_UNIT) * l);
+                    for (u8 j = 0; j < k; ++j) {
+                        cops[tuple[j] / BITSET_WIDTH] |= 1U << (tuple[j] % BITSET_WIDTH);
+                    }
+                }
+
+                u8 *count_t = count + (size_t) T * n;
+                for (u64 a = adj_start[r_prime]; a < adj_start[r_prime + 1]; ++a) {
+                    u32 r = adj[a];
+                    if (!(cops[r / BITSET_WIDTH] & (1U << (r % BITSET_WIDTH))) && 0 == --count_t[r]) {
+                        u64 c = T * n + r;
+                        robber_won[c / BITSET_WIDTH] |= 1U << (c % BITSET_WIDTH);
+                    }
+                }
+            }
+        }
+    }
+
+    if (NULL != arena) {
+        arena_release(arena, mark);
+    } else {
+        free(phi_parts);
+        free(count);
+        free(robber_won);
+        free(cops_won);
+        free(adj_start);
+        free(adj);
+        free(weight);
+        free(tuple);
+        free(pos);
+        free(partial);
+        free(cops);
+    }
+
+    certificate_fill(ctx->cert, satisfied, k, n, N, winner, strategy);
+
+    return satisfied;
+}
+
+/**
+ * One phase of a round of the m4rm engine, on a block of its rows (see m4rm_phase)
+ */
+typedef struct {
+    // -1 for the product of phi with the adjacency matrix, otherwise the coordinate the
+    // intersection over the neighbours runs along
+    i32 axis;
+    u32 n;
+    u32 l;
+    // The vertices a table covers, M4RM_WIDE or M4RM_NARROW
+    u8 width;
+    // The weight of the coordinate of the axis in the encoding of a position
+    u64 weight;
+    const BITSET_DATA_UNIT *in;
+    BITSET_DATA_UNIT *out;
+    // The rows of g, n rows of l blocks
+    const BITSET_DATA_UNIT *adjacency;
+    // The tables of the adjacency matrix, shared (product), or room for the tables of a
+    // fiber (intersection)
+    BITSET_DATA_UNIT *tables;
+    // The rows (product) or the fibers (intersection) of this block
+    u64 from;
+    u64 to;
+} m4rm_job_t;
+
+/**
+ * The tables of the Four Russians method for n source rows of l blocks, src[0],
+ * src[stride], ..., src[(n - 1) stride]: for every group of width consecutive sources, the
+ * union of each of its 2^width subsets. Each is one union away from an earlier one.
+ * @param tables where to write them, ceil(n / width) groups of 2^width entries of l blocks
+ * @param width the sources in a group (divides BITSET_WIDTH)
+ * @param n the number of sources
+ * @param l the blocks of a row
+ * @param src the first source
+ * @param stride the blocks from a source to the next
+ * @param complement if the sources are taken complemented
+ */
+static void m4rm_tables(BITSET_DATA_UNIT *tables, u8 width, u32 n, u32 l, const BITSET_DATA_UNIT *src, u64 stride,
+                        bool complement) {
+    u32 groups = (n + width - 1) / width;
+    BITSET_DATA_UNIT flip = complement ? ~0U : 0;
+
+    for (u32 group = 0; group < groups; ++group) {
+        BITSET_DATA_UNIT *table = tables + ((size_t) group << width) * l;
+        memset(table, 0, sizeof(BITSET_DATA_UNIT) * l);
+
+        for (u32 s = 1; s < (1U << width); ++s) {
+            BITSET_DATA_UNIT *entry = table + (size_t) s * l;
+            // The subset without its lowest source, and that source
+            const BITSET_DATA_UNIT *rest = table + (size_t) (s & (s - 1)) * l;
+            u32 v = group * width + __builtin_ctz(s);
+            if (v >= n) {
+                // Past the last vertex: never looked up
+                memcpy(entry, rest, sizeof(BITSET_DATA_UNIT) * l);
+                continue;
+            }
+
+            const BITSET_DATA_UNIT *row = src + (size_t) v * stride;
+            for (u32 w = 0; w < l; ++w) {
+                entry[w] = rest[w] | (row[w] ^ flip);
+            }
+        }
+    }
+}
+
+/**
+ * A row of a Boolean product with the Four Russians method: the union of the sources
+ * a selector picks, one table lookup per group of sources
+ * @param out where to write the row, l blocks
+ * @param tables the tables of the sources (see m4rm_tables)
+ * @param width the sources in a group
+ * @param groups the number of groups
+ * @param l the blocks of a row
+ * @param sel the selector, a set of sources
+ * @param complement if the union is written complemented
+ */
+static ALWAYS_INLINE void m4rm_row(BITSET_DATA_UNIT *out, const BITSET_DATA_UNIT *tables, u8 width, u32 groups, u32 l,
+                                   const BITSET_DATA_UNIT *sel, bool complement) {
+    BITSET_DATA_UNIT mask = (1U << width) - 1U;
+    memset(out, 0, sizeof(BITSET_DATA_UNIT) * l);
+
+    for (u32 group = 0; group < groups; ++group) {
+        u32 bit = group * width;
+        u32 s = (sel[bit / BITSET_WIDTH] >> (bit % BITSET_WIDTH)) & mask;
+        if (0 != s) {
+            const BITSET_DATA_UNIT *entry = tables + (((size_t) group << width) + s) * l;
+            for (u32 w = 0; w < l; ++w) {
+                out[w] |= entry[w];
+            }
+        }
+    }
+
+    if (complement) {
+        for (u32 w = 0; w < l; ++w) {
+            out[w] = ~out[w];
+        }
+    }
+}
+
+/**
+ * Run a phase of a round of the m4rm engine on a block of rows.
+ *  - The product: row T of the output is N[phi(T)], the union of the rows of g that
+ *    phi(T) picks, with the tables of the adjacency matrix.
+ *  - The intersection along a coordinate: a fiber is the n positions that differ only
+ *    there. Row t of a fiber is the intersection of the rows of the fiber that N[t]
+ *    picks, that is the complement of the union of their complements: again a product,
+ *    with the tables of the complemented rows of the fiber.
+ * @param job_void the phase (m4rm_job_t)
+ * @return null
+ */
+static void *m4rm_phase(void *job_void) {
+    m4rm_job_t *job = (m4rm_job_t *) job_void;
+    u32 n = job->n, l = job->l;
+    u8 width = job->width;
+    u32 groups = (n + width - 1) / width;
+
+    if (job->axis < 0) {
+        for (u64 T = job->from; T < job->to; ++T) {
+            m4rm_row(job->out + (size_t) T * l, job->tables, width, groups, l, job->in + (size_t) T * l, FALSE);
+        }
+        return NULL;
+    }
+
+    u64 weight = job->weight;
+    for (u64 f = job->from; f < job->to; ++f) {
+        // The first position of the fiber; the others are weight apart
+        u64 base = f / weight * n * weight + f % weight;
+        m4rm_tables(job->tables, width, n, l, job->in + (size_t) base * l, weight * l, TRUE);
+        for (u32 t = 0; t < n; ++t) {
+            m4rm_row(job->out + (size_t) (base + t * weight) * l, job->tables, width, groups, l,
+                     job->adjacency + (size_t) t * l, TRUE);
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Run a phase on row blocks split across threads; the calling thread takes the first
+ * block, and the ones of threads that could not be created
+ * @param job the phase, its tables to share (product) or room for threads of them (intersection)
+ * @param count the rows (product) or the fibers (intersection)
+ * @param threads the number of threads
+ * @param table_blocks the blocks of the tables of one thread, 0 if they are shared
+ */
+static void m4rm_run(m4rm_job_t *job, u64 count, u32 threads, size_t table_blocks) {
+    if (threads > count) {
+        threads = count > 0 ? count : 1;
+    }
+
+    m4rm_job_t jobs[threads];
+    pthread_t ids[threads];
+    bool started[threads];
+
+    for (u32 i = 0; i < threads; ++i) {
+        jobs[i] = *job;
+        jobs[i].from = count * i / threads;
+        jobs[i].to = count * (i + 1) / threads;
+        jobs[i].tables = job->tables + table_blocks * i;
+        started[i] = i > 0 && 0 == pthread_create(ids + i, NULL, m4rm_phase, jobs + i);
+    }
+
+    for (u32 i = 0; i < threads; ++i) {
+        if (!started[i]) {
+            m4rm_phase(jobs + i);
+        }
+    }
+    for (u32 i = 1; i < threads; ++i) {
+        if (started[i]) {
+            pthread_join(ids[i], NULL);
+        }
+    }
+}
+
+/**
+ * Find the neighbour of a position whose update removes a robber position, for the
+ * strategy of a certificate
+ * @param k the number of cops
+ * @param tuple the coordinates of the position
+ * @param adj_start the starts of the closed neighbourhoods of g in adj
+ * @param adj the closed neighbourhoods of g, as lists
+ * @param weight the weight of each coordinate in the encoding of a position
+ * @param nphi N[phi] of every position, as the round started
+ * @param l the blocks of an entry
+ * @param u the robber position
+ * @return a neighbour T with u out of N[phi(T)]
+ */
+static u64 m4rm_witness(u8 k, const u32 *tuple, const u64 *adj_start, const u32 *adj, const u64 *weight,
+                        const BITSET_DATA_UNIT *nphi, u32 l, u32 u) {
+    u64 pos[k];
+    u64 partial[k + 1];
+    partial[0] = 0;
+    for (u8 j = 0; j < k; ++j) {
+        pos[j] = adj_start[tuple[j]];
+        partial[j + 1] = partial[j] + adj[pos[j]] * weight[j];
+    }
+
+    while (TRUE) {
+        u64 T = partial[k];
+        if (!(nphi[(size_t) T * l + u / BITSET_WIDTH] & (1U << (u % BITSET_WIDTH)))) {
+            return T;
+        }
+
+        i32 j = k - 1;
+        while (j >= 0 && ++pos[j] == adj_start[tuple[j] + 1]) {
+            pos[j] = adj_start[tuple[j]];
+            j--;
+        }
+        if (j < 0) {
+            // Not reached: the intersection removed u, so some neighbour did
+            return T;
+        }
+        for (; j < k; ++j) {
+            partial[j + 1] = partial[j] + adj[pos[j]] * weight[j];
+        }
+    }
+}
+
+/**
+ * The fixed point in rounds, every position at once, instead of a position at a time.
+ * A round computes N[phi(T)] for every position T as the Boolean product of phi (N rows
+ * of n bits) with the adjacency matrix of g. It then intersects phi(T') with N[phi(T)]
+ * over every neighbour T of T': the neighbours form a product of closed neighbourhoods,
+ * so the intersection is taken one coordinate at a time, each a product with the
+ * adjacency matrix as well. The products use the Four Russians method (tables of the
+ * unions of groups of rows) and are split by row blocks across ctx->threads threads.
+ * Rounds go until one changes nothing; this is the fixed point of the worklist engines,
+ * each round costing about (k + 1) N n l / width block operations whatever changed.
+ * @param g the graph
+ * @param k the cop number "target"
+ * @param ctx the solver context
+ * @return if k cops win on g
+ */
+static bool algo2_m4rm(graph_t *g, u8 k, solver_ctx_t *ctx) {
+    arena_t *arena = ctx->arena;
+    arena_mark_t mark;
+    if (NULL != arena) {
+        mark = arena_mark(arena);
+    }
+
+    u32 n = g->n;
+    u64 N = ipow(n, k);
+    u32 l = WORDS(n);
+    u32 threads = ctx->threads > 1 ? ctx->threads : 1;
+
+    // The product's tables serve every position; a fiber's only its n rows, so they
+    // are narrower when n is small, to be cheaper to build
+    u8 product_width = N >= M4RM_WIDE_ROWS ? M4RM_WIDE : M4RM_NARROW;
+    u8 fiber_width = n >= M4RM_WIDE_ROWS ? M4RM_WIDE : M4RM_NARROW;
+    size_t product_blocks = ((size_t) (n + product_width - 1) / product_width << product_width) * l;
+    size_t fiber_blocks = ((size_t) (n + fiber_width - 1) / fiber_width << fiber_width) * l;
+
+    // See algo2_materialized
+    u64 *strategy = NULL;
+    if (NULL != ctx->cert && NULL == (strategy = strategy_new(N, n))) {
+        return refuse(ctx, n, k);
+    }
+    u64 winner = 0;
+
+    // N[phi], and the intersections along the coordinates in turn, ping-ponging between
+    // two buffers. N[phi] is kept through the round for the strategy; otherwise it is
+    // one of the two.
+    BITSET_DATA_UNIT *phi_parts = mem_alloc_array(arena, N * l, sizeof(BITSET_DATA_UNIT));
+    BITSET_DATA_UNIT *nphi = mem_alloc_array(arena, N * l, sizeof(BITSET_DATA_UNIT));
+    BITSET_DATA_UNIT *across = mem_alloc_array(arena, N * l, sizeof(BITSET_DATA_UNIT));
+    BITSET_DATA_UNIT *spare = NULL != strategy ? mem_alloc_array(arena, N * l, sizeof(BITSET_DATA_UNIT)) : nphi;
+    BITSET_DATA_UNIT *adjacency = mem_alloc_array(arena, (u64) n * l, sizeof(BITSET_DATA_UNIT));
+    BITSET_DATA_UNIT *product_tables = mem_alloc_array(arena, product_blocks, sizeof(BITSET_DATA_UNIT));
+    BITSET_DATA_UNIT *fiber_tables = mem_alloc_array(arena, fiber_blocks * threads, sizeof(BITSET_DATA_UNIT));
+    if (NULL == phi_parts || NULL == nphi || NULL == across || NULL == spare || NULL == adjacency ||
+        NULL == product_tables || NULL == fiber_tables) {
+        if (NULL != arena) {
+            arena_release(arena, mark);
+        } else {
+            free(phi_parts);
+            free(nphi);
+            free(across);
+            if (NULL != strategy) {
+                free(spare);
+            }
+            free(adjacency);
+            free(product_tables);
+            free(fiber_tables);
+        }
+        free(strategy);
+        return refuse(ctx, n, k);
+    }
+
+    // See dominators_new
+    BITSET_DATA_UNIT *dom = ctx->dominance ? dominators_new(g, arena) : NULL;
+    init_phi(g, k, phi_parts, l, N, arena, NULL, dom);
+
+    for (u32 v = 0; v < n; ++v) {
+        memcpy(adjacency + (size_t) v * l, g->rows[v]->parts, sizeof(BITSET_DATA_UNIT) * l);
+    }
+    // The adjacency matrix does not change: its tables are built once
+    m4rm_tables(product_tables, product_width, n, l, adjacency, l, FALSE);
+
+    u64 weight[k];
+    for (u8 j = 0; j < k; ++j) {
+        weight[j] = ipow(n, k - j - 1);
+    }
+
+    // The strategy names, for every robber position removed, a neighbour that removed it
+    u64 *adj_start = NULL;
+    u32 *adj = NULL;
+    u32 tuple[k];
+    if (NULL != strategy) {
+        graph_lists_in(arena, g, &adj_start, &adj);
+    }
+
+    bool satisfied = FALSE;
+    bool changed = TRUE;
+
+    while (changed && !satisfied && !ctx->timed_out) {
+        changed = FALSE;
+
+        m4rm_job_t product = {-1, n, l, product_width, 0, phi_parts, nphi, adjacency, product_tables, 0, 0};
+        m4rm_run(&product, N, threads, 0);
+
+        const BITSET_DATA_UNIT *in = nphi;
+        BITSET_DATA_UNIT *out = across;
+        for (u8 j = 0; j < k; ++j) {
+            m4rm_job_t intersection = {j, n, l, fiber_width, weight[j], in, out, adjacency, fiber_tables, 0, 0};
+            m4rm_run(&intersection, N / n, threads, fiber_blocks);
+            in = out;
+            out = out == across ? spare : across;
+        }
+
+        // in holds, for every position, the intersection of N[phi] over its neighbours
+        for (u64 T = 0; T < N; ++T) {
+            if (budget_spent(ctx)) {
+                break;
+            }
+
+            BITSET_DATA_UNIT *phi_t = phi_parts + (size_t) T * l;
+            const BITSET_DATA_UNIT *reach = in + (size_t) T * l;
+
+            if (NULL != strategy) {
+                int_to_tuple(k, tuple, n, T);
+                for (u32 w = 0; w < l; ++w) {
+                    BITSET_DATA_UNIT removed = phi_t[w] & ~reach[w];
+                    while (0 != removed) {
+                        u32 u = w * BITSET_WIDTH + __builtin_ctz(removed);
+                        removed &= removed - 1;
+                        strategy[(size_t) T * n + u] = m4rm_witness(k, tuple, adj_start, adj, weight, nphi, l, u);
+                    }
+                }
+            }
+
+            BITSET_DATA_UNIT change = 0, left = 0;
+            for (u32 w = 0; w < l; ++w) {
+                BITSET_DATA_UNIT old = phi_t[w];
+                phi_t[w] = old & reach[w];
+                change |= old ^ phi_t[w];
+                left |= phi_t[w];
+            }
+
+            if (!left) {
+                satisfied = TRUE;
+                winner = T;
+                break;
+            }
+            changed |= 0 != change;
+        }
+    }
+
+    if (satisfied && NULL != strategy && NULL != dom) {
+        strategy_inherit(g, k, N, strategy, dom, arena);
+    }
+
+    if (NULL != arena) {
+        arena_release(arena, mark);
+    } else {
+        free(dom);
+        free(phi_parts);
+        free(nphi);
+        free(across);
+        if (NULL != strategy) {
+            free(spare);
+        }
+        free(adjacency);
+        free(product_tables);
+        free(fiber_tables);
+        free(adj_start);
+        free(adj);
+    }
+
+    certificate_fill(ctx->cert, satisfied, k, n, N, winner, strategy);
+
+    return satisfied;
+}
+
+/**
+ * Bytes taken by the delta engine: phi, the deltas, the counters, the dirty set and
+ * the neighbourhood lists of g
+ * @param g the graph
+ * @param k the cop number "target"
+ * @param cert if a certificate is recorded
+ * @return the estimate, in bytes, as a double since it may be past what size_t holds
+ */
+static double delta_memory(graph_t *g, u8 k, bool cert) {
+    double n = (double) g->n;
+    double N = 1;
+
+    for (u8 j = 0; j < k; ++j) {
+        N *= n;
+    }
+
+    double bytes = 2 * N * sizeof(BITSET_DATA_UNIT) * WORDS(g->n) + N * n + N / 8 + n * n * sizeof(u32);
+
+    if (cert) {
+        bytes += N * n * sizeof(u64);
+    }
+
+    return bytes;
+}
+
+/**
+ * Bytes taken by the retrograde engine: phi, the counters, the states to update and
+ * the neighbourhood lists of g
+ * @param g the graph
+ * @param k the cop number "target"
+ * @param cert if a certificate is recorded
+ * @return the estimate, in bytes, as a double since it may be past what size_t holds
+ */
+static double retrograde_memory(graph_t *g, u8 k, bool cert) {
+    double n = (double) g->n;
+    double N = 1;
+
+    for (u8 j = 0; j < k; ++j) {
+        N *= n;
+    }
+
+    double bytes = N * sizeof(BITSET_DATA_UNIT) * WORDS(g->n) + N * n + N * n / 4 + n * n * sizeof(u32);
+
+    if (cert) {
+        bytes += N * n * sizeof(u64);
+    }
+
+    return bytes;
+}
+
+/**
+ * Bytes taken by the m4rm engine: phi, N[phi] and the intersections (one more for a
+ * certificate), the adjacency matrix and the tables
+ * @param g the graph
+ * @param k the cop number "target"
+ * @param cert if a certificate is recorded
+ * @param threads the threads of the run, each with the tables of a fiber
+ * @return the estimate, in bytes, as a double since it may be past what size_t holds
+ */
+static double m4rm_memory(graph_t *g, u8 k, bool cert, u32 threads) {
+    double n = (double) g->n;
+    double N = 1;
+
+    for (u8 j = 0; j < k; ++j) {
+        N *= n;
+    }
+
+    double l = WORDS(g->n);
+    double groups = (double) ((g->n + M4RM_WIDE - 1) / M4RM_WIDE);
+    u32 fiber_width = g->n >= M4RM_WIDE_ROWS ? M4RM_WIDE : M4RM_NARROW;
+    double fiber = (double) ((g->n + fiber_width - 1) / fiber_width) * (1U << fiber_width) * l;
+    double bytes = sizeof(BITSET_DATA_UNIT) * ((cert ? 4 : 3) * N * l + n * l + groups * (1U << M4RM_WIDE) * l +
+                                               (threads > 1 ? threads : 1) * fiber);
+
+    if (cert) {
+        bytes += N * n * sizeof(u64);
+    }
+
+    return bytes;
+}
+
+/**
+ * The largest closed neighbourhood of a graph
+ * @param g the graph
+ * @return its size
+ */
+static u32 max_closed_degree(graph_t *g) {
+    u32 max = 0;
+    for (u32 v = 0; v < g->n; ++v) {
+        u32 d = bitset_count(g->rows[v]);
+        max = d > max ? d : max;
+    }
+    return max;
+}
+
+/**
+ * Bytes taken by the materialized engine: the tensor graph as lists, phi and the worklist
+ * @param g the graph
+ * @param k the cop number "target"
+ * @param cert if a certificate is recorded
+ * @param policy the order of the worklist
+ * @return the estimate, in bytes, as a double since it may be past what size_t holds
+ */
+static double materialized_memory(graph_t *g, u8 k, bool cert, worklist_policy_t policy) {
+    double n = (double) g->n;
+    double N = 1, closed = 0, lists = 1;
+
+    for (u32 v = 0; v < g->n; ++v) {
+        closed += bitset_count(g->rows[v]);
+    }
+    for (u8 j = 0; j < k; ++j) {
+        N *= n;
+        // Positions' neighbourhoods are products of their coordinates' ones
+        lists *= closed;
+    }
+
+    double phi = sizeof(bitset_t) + sizeof(BITSET_DATA_UNIT) * WORDS(g->n);
+    double bytes = N * (phi + sizeof(u64)) + lists * sizeof(u32) + vertice_queue_memory(N, policy);
+
+    if (cert) {
+        bytes += N * n * sizeof(u64);
+    }
+
+    return bytes;
+}
+
+/**
+ * Bytes taken by the sweep engine: phi, the dirty set and the neighbourhood lists of g
+ * @param g the graph
+ * @param k the cop number "target"
+ * @param cert if a certificate is recorded
+ * @return the estimate, in bytes, as a double since it may be past what size_t holds
+ */
+static double sweep_memory(graph_t *g, u8 k, bool cert) {
+    double n = (double) g->n;
+    double N = 1;
+
+    for (u8 j = 0; j < k; ++j) {
+        N *= n;
+    }
+
+    double bytes = N * sizeof(BITSET_DATA_UNIT) * WORDS(g->n) + N / 8 + n * n * sizeof(u32);
+
+    if (cert) {
+        bytes += N * n * sizeof(u64);
+    }
+
+    return bytes;
+}
+
+/**
+ * Bytes taken by the word engine: phi and the dirty set
+ * @param g the graph
+ * @param k the cop number "target"
+ * @param cert if a certificate is recorded
+ * @return the estimate, in bytes, as a double since it may be past what size_t holds
+ */
+static double word_memory(graph_t *g, u8 k, bool cert) {
+    double n = (double) g->n;
+    double N = 1;
+
+    for (u8 j = 0; j < k; ++j) {
+        N *= n;
+    }
+
+    double bytes = N * sizeof(word_t) + N / 8;
+
+    if (cert) {
+        bytes += N * n * sizeof(u64);
+    }
+
+    return bytes;
+}
+
+engine_t select_engine(graph_t *g, u8 k, solver_ctx_t *ctx) {
+    bool cert = NULL != ctx->cert;
+    double budget = (double) ctx->resident_budget;
+
+    u32 n = g->n;
+    double N = 1;
+    for (u8 j = 0; j < k; ++j) {
+        N *= n;
+    }
+
+    if (ENGINE_AUTO != ctx->engine) {
+        if (ENGINE_OUT_OF_CORE == ctx->engine && NULL == ctx->scratch_dir) {
+            return ENGINE_SWEEP;
+        }
+        if (ENGINE_MATERIALIZED == ctx->engine && N > MATERIALIZED_MAX_STATES) {
+            return ENGINE_SWEEP;
+        }
+        if (ENGINE_WORD == ctx->engine && n > WORD_BITS) {
+            return ENGINE_SWEEP;
+        }
+        if ((ENGINE_DELTA == ctx->engine || ENGINE_RETROGRADE == ctx->engine) &&
+            max_closed_degree(g) > COUNTER_MAX_DEGREE) {
+            return ENGINE_SWEEP;
+        }
+        return ctx->engine;
+    }
+
+    // The rows are reflexive
+    u64 degrees = 0;
+    for (u32 v = 0; v < n; ++v) {
+        degrees += bitset_count(g->rows[v]) - 1;
+    }
+    double density = n > 1 ? (double) degrees / ((double) n * (n - 1)) : 1;
+
+    u32 max_states = density >= ctx->tuning->dense_density ? ctx->tuning->materialize_max_states_dense
+                                                           : ctx->tuning->materialize_max_states_sparse;
+
+    // Only the materialized engine orders its worklist
+    if (WORKLIST_AUTO != ctx->worklist) {
+        max_states = MATERIALIZED_MAX_STATES;
+    }
+
+    if (N <= max_states && materialized_memory(g, k, cert, ctx->worklist) <= budget) {
+        return ENGINE_MATERIALIZED;
+    }
+
+    if (n <= WORD_BITS && (NULL == ctx->scratch_dir || word_memory(g, k, cert) <= budget)) {
+        return ENGINE_WORD;
+    }
+
+    if (NULL == ctx->scratch_dir || sweep_memory(g, k, cert) <= budget) {
+        return ENGINE_SWEEP;
+    }
+
+    return ENGINE_OUT_OF_CORE;
+}
+
+size_t bonato_al_memory(graph_t *g, u8 k, solver_ctx_t *ctx) {
+    double bytes;
+    switch (select_engine(g, k, ctx)) {
+        case ENGINE_MATERIALIZED:
+            bytes = materialized_memory(g, k, NULL != ctx->cert, ctx->worklist);
+            break;
+        case ENGINE_WORD:
+            bytes = word_memory(g, k, NULL != ctx->cert);
+            break;
+        case ENGINE_DELTA:
+            bytes = delta_memory(g, k, NULL != ctx->cert);
+            break;
+        case ENGINE_RETROGRADE:
+            bytes = retrograde_memory(g, k, NULL != ctx->cert);
+            break;
+        case ENGINE_M4RM:
+            bytes = m4rm_memory(g, k, NULL != ctx->cert, ctx->threads);
+            break;
+        case ENGINE_OUT_OF_CORE:
+            // What stays resident of phi, and the neighbourhood lists of g
+            bytes = (double) ctx->resident_budget + (double) g->n * g->n * sizeof(u32);
+            if (NULL != ctx->cert) {
+                // The strategy is in memory
+                bytes += pow((double) g->n, k + 1) * sizeof(u64);
+            }
+            break;
+        default:
+            bytes = sweep_memory(g, k, NULL != ctx->cert);
+            break;
+    }
+
+    return bytes >= (double) (size_t) -1 ? (size_t) -1 : (size_t) bytes;
+}
+
+bool bonato_al_algo2(graph_t *g, u8 k, solver_ctx_t *ctx) {
+
+    if (k >= 4 && !ctx->quiet) {
+        printf("%d, ", k);
+    }
+
+#ifdef USE_PITFALL_CHECK
+    if (1 == k && !graph_has_pitfall(g, 1)) {
+        return FALSE;
+    }
+#endif
+
+    // phi alone (and the strategy, for a certificate) must be addressable
+    u64 N;
+    size_t bytes;
+    if (!ipow_checked(g->n, k, &N) ||
+        !size_mul(&bytes, N, sizeof(BITSET_DATA_UNIT) * WORDS(g->n)) ||
+        (NULL != ctx->cert && !size_mul(&bytes, N, sizeof(u64) * g->n))) {
+        if (!ctx->quiet) {
+            printf("%zu^%u positions overflow the address space. Giving up.\n", g->n, k);
+        }
+        ctx->refused = TRUE;
+        return FALSE;
+    }
+
+    u64 start = trace_now(ctx->trace);
+    bool won;
+    switch (select_engine(g, k, ctx)) {
+        case ENGINE_MATERIALIZED:
+            won = algo2_materialized(g, k, ctx);
+            break;
+        case ENGINE_WORD:
+            won = algo2_word(g, k, ctx);
+            break;
+        case ENGINE_DELTA:
+            won = algo2_delta(g, k, ctx);
+            break;
+        case ENGINE_RETROGRADE:
+            won = retrograde(g, k, ctx);
+            break;
+        case ENGINE_M4RM:
+            won = algo2_m4rm(g, k, ctx);
+            break;
+        case ENGINE_OUT_OF_CORE:
+            won = algo2_sweep(g, k, ctx, ctx->scratch_dir);
+            break;
+        default:
+            won = algo2_sweep(g, k, ctx, NULL);
+    }
+    trace_span(ctx->trace, TRACE_FIXED_POINT, start, g->n, k);
+
+    return won;
+}
+
+
+u32 cop_number(graph_t *g, u8 max_k, solver_ctx_t *ctx) {
+    u32 k = 1;
+    cop_bound_t upper = {0, BOUND_NONE};
+
+    if (g->n > 0) {
+        // Every k below the lower bound would fail; skip them
+        k = cop_lower_bound(g);
+        upper = cop_upper_bound(g);
+    }
+
+    // Resuming: every k before this one already failed
+    if (ctx->start_k > k) {
+        k = ctx->start_k;
+    }
+
+    ctx->decided = BOUND_NONE;
+    ctx->refused = FALSE;
+    ctx->runs = 0;
+    ctx->pops = 0;
+    ctx->timed_out = FALSE;
+    ctx->timeout_k = 0;
+    if (ctx->time_budget > 0) {
+        ctx->deadline = monotonic_seconds() + ctx->time_budget;
+    }
+
+    while (k <= max_k) {
+        // Every smaller k is known to fail, so a bound at k settles it; a certificate
+        // needs the fixed point's strategy, which a bound does not give
+        if (NULL == ctx->cert && upper.kind != BOUND_NONE && upper.value <= k) {
+            ctx->decided = upper.kind;
+            return k;
+        }
+
+        if (NULL != ctx->progress_k) {
+            __atomic_store_n(ctx->progress_k, k, __ATOMIC_RELAXED);
+        }
+
+        size_t bytes = 0;
+        if (NULL != ctx->admission) {
+            bytes = bonato_al_memory(g, k, ctx);
+            if (!ctx->may_defer) {
+                u64 start = trace_now(ctx->trace);
+                admission_wait(ctx->admission, bytes);
+                trace_span(ctx->trace, TRACE_ADMISSION, start, g->n, k);
+            } else if (!admission_try(ctx->admission, bytes)) {
+                ctx->deferred_k = k;
+                ctx->deferred_bytes = bytes;
+                return 0;
+            }
+        }
+
+        bool won = bonato_al_algo2(g, k, ctx);
+        ctx->runs++;
+
+        if (NULL != ctx->admission) {
+            admission_release(ctx->admission, bytes);
+        }
+
+        if (won) {
+            return k;
+        }
+
+        if (ctx->timed_out) {
+            // Unknown from here on; the graph may be run again with more
+            ctx->timeout_k = k;
+            return max_k + 1;
+        }
+
+        if (ctx->refused) {
+            // Unknown from here on, like a graph over max_k
+            return max_k + 1;
+        }
+
+        k++;
+    }
+
+    if (!ctx->quiet) {
+        printf("Over %d.\n", max_k);
+    }
+    return max_k + 1;
+}
+
+void certificate_clear(certificate_t *cert) {
+    free(cert->strategy);
+    cert->strategy = NULL;
+    cert->k = 0;
+    cert->n = 0;
+    cert->N = 0;
+    cert->start = 0;
+}
+
+/**
+ * Write an encoded cop position as a tuple of vertices
+ * @param out the stream
+ * @param cert the certificate (for k and n)
+ * @param tuple a k-wide buffer
+ * @param T the encoded position
+ */
+static void certificate_write_position(FILE *out, certificate_t *cert, u32 *tuple, u64 T) {
+    int_to_tuple(cert->k, tuple, cert->n, T);
+    fprintf(out, "(");
+    for (u8 c = 0; c < cert->k; ++c) {
+        fprintf(out, c > 0 ? " %u" : "%u", tuple[c]);
+    }
+    fprintf(out, ")");
+}
+
+void certificate_write(FILE *out, graph_t *g, certificate_t *cert) {
+    u32 n = cert->n;
+    size_t states = (size_t) cert->N * n;
+
+    u32 *tuple = malloc(sizeof(u32) * cert->k);
+    bitset_t *seen = new_bitset(states);
+
+    // Round by round frontier of (cops, robber) states, cops to move
+    size_t *frontier = malloc(sizeof(size_t) * states);
+    size_t *next = malloc(sizeof(size_t) * states);
+    size_t frontier_sz = 0;
+
+    fprintf(out, "start ");
+    certificate_write_position(out, cert, tuple, cert->start);
+    fprintf(out, "\n");
+
+    // The robber may start anywhere
+    for (u32 u = 0; u < n; ++u) {
+        size_t s = (size_t) cert->start * n + u;
+        bitset_set(seen, s, EDGE);
+        frontier[frontier_sz++] = s;
+    }
+
+    for (u32 round = 0; frontier_sz > 0; ++round) {
+        size_t next_sz = 0;
+        fprintf(out, "round %u\n", round);
+
+        for (size_t i = 0; i < frontier_sz; ++i) {
+            u64 T = frontier[i] / n;
+            u32 u = frontier[i] % n;
+            u64 T_next = cert->strategy[frontier[i]];
+
+            certificate_write_position(out, cert, tuple, T);
+            fprintf(out, " %u -> ", u);
+
+            if (CERT_NO_MOVE == T_next) {
+                // The robber stands next to a cop: that cop captures
+                fprintf(out, "capture\n");
+                continue;
+            }
+
+            certificate_write_position(out, cert, tuple, T_next);
+            fprintf(out, "\n");
+
+            u32 moves_sz;
+            u32 *moves = bitset_indices(g->rows[u], &moves_sz);
+            for (u32 m = 0; m < moves_sz; ++m) {
+                size_t s = (size_t) T_next * n + moves[m];
+                if (!bitset_set(seen, s, EDGE)) {
+                    next[next_sz++] = s;
+                }
+            }
+            free(moves);
+        }
+
+        size_t *swap = frontier;
+        frontier = next;
+        next = swap;
+        frontier_sz = next_sz;
+    }
+
+    free(frontier);
+    free(next);
+    bitset_destroy(seen);
+    free(tuple);
+}
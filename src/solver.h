@@ -0,0 +1,187 @@
+#ifndef COPNV2_SOLVER_H
+#define COPNV2_SOLVER_H
+
+#include <stdio.h>
+#include "types.h"
+#include "graph.h"
+#include "bounds.h"
+#include "arena.h"
+#include "admission.h"
+#include "tuning.h"
+#include "vertice_queue.h"
+#include "trace.h"
+
+/**
+ * A certificate that k cops win on a graph. It records the starting position of the cops
+ * and, for every (cops, robber) position the cops can be brought to, the position
+ * the cops move to next. Following the strategy, the robber is captured in a finite number
+ * of rounds whatever he does.
+ */
+typedef struct {
+    u8 k;
+    u32 n;
+    u64 N;
+    // The winning start position, as an encoded tuple (see int_to_tuple)
+    u64 start;
+    // For each state T * n + u (cops on T, robber on u, cops to move), the encoded
+    // tuple the cops move to. CERT_NO_MOVE if the robber is adjacent to the cops.
+    u64 *strategy;
+} certificate_t;
+
+#define CERT_NO_MOVE 0xFFFFFFFFFFFFFFFFULL
+
+// Positions are u64, but the materialized engine lists tensor neighbours as u32
+#define MATERIALIZED_MAX_STATES 0xFFFFFFFFULL
+
+// Graphs the word engine takes: a set of vertices is a single u64
+#define WORD_BITS 64
+
+// Graphs the counter engines (delta, retrograde) take: their counters are bytes
+#define COUNTER_MAX_DEGREE 255
+
+/**
+ * What a worker hands to the solver: where to take memory from, what to produce
+ * besides the answer, and (on return) how the answer was obtained.
+ */
+typedef struct {
+    // Working memory (null for the heap)
+    arena_t *arena;
+    // If not null, filled with a winning strategy for the cop number found
+    certificate_t *cert;
+    // Directory for out-of-core storage (null to always stay in memory)
+    const char *scratch_dir;
+    // Memory a single run may take: past it, the engine selection falls back to
+    // engines that need less, up to going out of core. Also how much of the
+    // out-of-core storage may stay resident.
+    size_t resident_budget;
+    // The engine to use, ENGINE_AUTO to select one per graph and per k
+    engine_t engine;
+    // The thresholds of the automatic selection
+    engine_tuning_t *tuning;
+    // Set by cop_number: the bound that decided, BOUND_NONE if it was the fixed point
+    bound_kind_t decided;
+    // Shared memory budget every run must be admitted by (null for none)
+    admission_t *admission;
+    // Whether cop_number may give up on a run that does not fit instead of waiting
+    bool may_defer;
+    // The k to start from (0 for the lower bound), when resuming a deferred graph
+    u32 start_k;
+    // Set by cop_number when it gave up: the k to resume from and what it needs
+    u32 deferred_k;
+    size_t deferred_bytes;
+    // Set by bonato_al_algo2 when the run could not be represented or allocated:
+    // its answer is then not an answer
+    bool refused;
+    // Set by cop_number: the number of times the fixed point ran
+    u32 runs;
+    // Do not report progress or failures on stdout (when embedded)
+    bool quiet;
+    // The order of the materialized engine's worklist; the sweeps always go in rounds.
+    // Anything but WORKLIST_AUTO makes the automatic selection materialize when it fits.
+    worklist_policy_t worklist;
+    // Set by cop_number: the positions popped from the worklists (or swept) by all the runs
+    u64 pops;
+    // Budgets of a graph, over all its runs: wall time in seconds and pops (0 for none)
+    double time_budget;
+    u64 pop_budget;
+    // Set by the engines when a budget ran out, which ends the run without an answer
+    bool timed_out;
+    // Set by cop_number: the k a budget ran out at, 0 if none did
+    u32 timeout_k;
+    // When the time budget runs out, on the monotonic clock (set by cop_number)
+    double deadline;
+    // Drop the robber positions dominated by another from phi (see dominators_new).
+    // The answer is the same; the retrograde engine does not prune.
+    bool dominance;
+    // Where to record the spans of the runs (null for no tracing)
+    trace_buffer_t *trace;
+    // If not null, cop_number stores the k it runs there (through __atomic_store_n), for
+    // progress reports
+    u32 *progress_k;
+    // Threads a run may split its work across, besides the calling one (0 or 1 for none).
+    // Only the m4rm engine does, by row blocks.
+    u32 threads;
+} solver_ctx_t;
+
+/**
+ * Computes the following equation:
+ * c(G) \leq k
+ * This algorithm is based off the one given at
+    @article{bonato2010cops,
+      title={Cops and robbers from a distance},
+      author={Bonato, Anthony and Chiniforooshan, Ehsan and Pra{\l}at, Pawe{\l}},
+      journal={Theoretical Computer Science},
+      volume={411},
+      number={43},
+      pages={3834--3844},
+      year={2010},
+      publisher={Elsevier}
+    }
+ * The fixed point stops as soon as a position is proven winning for the cops.
+ * The engine running it is picked by select_engine. A run whose sizes overflow, or
+ * whose storage cannot be allocated, is refused (see ctx->refused) rather than attempted.
+ * The engines check the budgets of the graph as they go, and give up once one runs out
+ * (see ctx->timed_out).
+ * @param g the graph
+ * @param k the cop number "target"
+ * @param ctx the solver context; the arena is rolled back on return
+ * @return if k cops win on g
+ */
+bool bonato_al_algo2(graph_t *g, u8 k, solver_ctx_t *ctx);
+
+/**
+ * Pick the engine for a run. Unless one is forced in the context, small state spaces
+ * (per the tuning, or any that fits when a worklist policy is asked for) are
+ * materialized; larger ones enumerate tensor neighbours on the fly, with one word per
+ * set of vertices when n <= WORD_BITS; those whose phi does not fit in
+ * ctx->resident_budget go out of core when there is a scratch directory.
+ * @param g the graph
+ * @param k the cop number "target"
+ * @param ctx the solver context
+ * @return the engine
+ */
+engine_t select_engine(graph_t *g, u8 k, solver_ctx_t *ctx);
+
+/**
+ * Estimate the peak memory bonato_al_algo2 needs for a graph
+ * @param g the graph
+ * @param k the cop number "target"
+ * @param ctx the solver context (for the storage it would pick)
+ * @return the estimate, in bytes (saturates instead of overflowing)
+ */
+size_t bonato_al_memory(graph_t *g, u8 k, solver_ctx_t *ctx);
+
+/**
+ * Compute the cop number of a graph, trying k = 1, 2, ... up to max_k. The search
+ * starts at the number of components, and stops without running the fixed point as
+ * soon as a cheap upper bound (see bounds.h) matches the current k, unless a
+ * certificate is asked for.
+ * @param g the graph
+ * @param max_k the maximum number of cops to try
+ * @param ctx the solver context. The certificate, if any, is filled for the returned
+ * k (if <= max_k). With admission control, every run waits for its memory to be
+ * available, or when deferring is allowed, makes cop_number return 0 and set
+ * ctx->deferred_k so the graph can be resumed later. The budgets start with the
+ * call; when one runs out, ctx->timeout_k is the k it ran out at.
+ * @return the cop number, or max_k + 1 if it is over max_k (or a run was refused or ran out
+ * of budget), or 0 if deferred
+ */
+u32 cop_number(graph_t *g, u8 max_k, solver_ctx_t *ctx);
+
+/**
+ * Release the memory held by a certificate (but not the structure itself)
+ * @param cert the certificate
+ */
+void certificate_clear(certificate_t *cert);
+
+/**
+ * Write the certificate in a human (and machine) checkable form. The strategy is
+ * written round by round, starting from the cops' start position and following every
+ * possible robber answer until capture.
+ * @param out the stream to write to
+ * @param g the graph the certificate is for
+ * @param cert the certificate
+ */
+void certificate_write(FILE *out, graph_t *g, certificate_t *cert);
+
+#endif //COPNV2_SOLVER_H
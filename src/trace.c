@@ -0,0 +1,91 @@
+#include "trace.h"
+#include <stdlib.h>
+
+static const char *trace_names[TRACE_KINDS] = {
+        "lock",
+        "input",
+        "admission",
+        "decode",
+        "tensor_power",
+        "fixed_point"
+};
+
+void trace_init(trace_t *t, u32 cap) {
+    pthread_mutex_init(&t->mut, NULL);
+    t->buffers = NULL;
+    t->next_tid = 0;
+    t->cap = cap;
+    t->origin = trace_clock();
+}
+
+void trace_destroy(trace_t *t) {
+    trace_buffer_t *b = t->buffers;
+    while (NULL != b) {
+        trace_buffer_t *next = b->next;
+        free(b->events);
+        free(b);
+        b = next;
+    }
+    pthread_mutex_destroy(&t->mut);
+}
+
+trace_buffer_t *trace_buffer_new(trace_t *t) {
+    if (NULL == t) {
+        return NULL;
+    }
+
+    trace_buffer_t *b = malloc(sizeof(trace_buffer_t));
+    if (NULL == b) {
+        return NULL;
+    }
+    if (NULL == (b->events = malloc(sizeof(trace_event_t) * t->cap))) {
+        free(b);
+        return NULL;
+    }
+    b->cap = t->cap;
+    b->count = 0;
+    b->graph = 0;
+
+    pthread_mutex_lock(&t->mut);
+    b->tid = t->next_tid++;
+    b->next = t->buffers;
+    t->buffers = b;
+    pthread_mutex_unlock(&t->mut);
+
+    return b;
+}
+
+void trace_record(trace_buffer_t *b, trace_kind_t kind, u64 start, u32 n, u32 k) {
+    trace_event_t *e = b->events + b->count++ % b->cap;
+    e->start = start;
+    e->duration = trace_clock() - start;
+    e->graph = b->graph;
+    e->n = n;
+    e->k = k;
+    e->kind = kind;
+}
+
+void trace_write(trace_t *t, FILE *out) {
+    fprintf(out, "{\"traceEvents\":[\n");
+    bool first = TRUE;
+
+    for (trace_buffer_t *b = t->buffers; NULL != b; b = b->next) {
+        fprintf(out, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"worker %u\"}}",
+                first ? "" : ",\n", b->tid, b->tid);
+        first = FALSE;
+
+        // Oldest first; the ones overwritten are lost
+        u64 from = b->count > b->cap ? b->count - b->cap : 0;
+        for (u64 i = from; i < b->count; ++i) {
+            trace_event_t *e = b->events + i % b->cap;
+            fprintf(out, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f",
+                    trace_names[e->kind], b->tid, (double) (e->start - t->origin) / 1e3, (double) e->duration / 1e3);
+            if (0 != e->n) {
+                fprintf(out, ",\"args\":{\"graph\":%llu,\"n\":%u,\"k\":%u}", e->graph, e->n, e->k);
+            }
+            fprintf(out, "}");
+        }
+    }
+
+    fprintf(out, "\n],\"displayTimeUnit\":\"ms\"}\n");
+}
@@ -0,0 +1,149 @@
+#ifndef COPNV2_TRACE_H
+#define COPNV2_TRACE_H
+
+#include <stdio.h>
+#include <time.h>
+#include <pthread.h>
+#include "types.h"
+
+// Events each thread keeps by default; past it, the oldest ones are overwritten
+#define TRACE_DEFAULT_EVENTS (1U << 16)
+
+/**
+ * What a thread was doing during a traced span
+ */
+typedef enum {
+    // Waiting for the task lock
+    TRACE_LOCK,
+    // Waiting for the input to provide a line
+    TRACE_INPUT,
+    // Waiting for the memory of a run to be admitted
+    TRACE_ADMISSION,
+    // Decoding a graph from graph6
+    TRACE_DECODE,
+    // Building the tensor graph of a run
+    TRACE_TENSOR_POWER,
+    // Running the fixed point for one k
+    TRACE_FIXED_POINT,
+    TRACE_KINDS
+} trace_kind_t;
+
+/**
+ * A span, with what it was about (n and k are 0 when it was not about a graph)
+ */
+typedef struct {
+    u64 start;
+    u64 duration;
+    u64 graph;
+    u32 n;
+    u32 k;
+    trace_kind_t kind;
+} trace_event_t;
+
+/**
+ * The events of one thread, a ring of the most recent ones. Only that thread writes to
+ * it, so recording takes no lock.
+ */
+typedef struct trace_buffer {
+    struct trace_buffer *next;
+    u32 tid;
+    // The graph the thread is on, for the events to come
+    u64 graph;
+    trace_event_t *events;
+    u32 cap;
+    // Recorded since the start; the ring holds the last min(count, cap)
+    u64 count;
+} trace_buffer_t;
+
+/**
+ * The buffers of all the threads traced, written out as a Chrome trace (a JSON file that
+ * chrome://tracing and Perfetto open) once they are done
+ */
+typedef struct {
+    pthread_mutex_t mut;
+    trace_buffer_t *buffers;
+    u32 next_tid;
+    u32 cap;
+    // Timestamps are in nanoseconds from here, on the monotonic clock
+    u64 origin;
+} trace_t;
+
+/**
+ * Initialize a trace
+ * @param t the structure
+ * @param cap the number of events each thread keeps
+ */
+void trace_init(trace_t *t, u32 cap);
+
+/**
+ * Free a trace and its buffers. The threads must be done with them.
+ * @param t the trace
+ */
+void trace_destroy(trace_t *t);
+
+/**
+ * Add a buffer to a trace, for a thread to record into
+ * @param t the trace (may be null, for no tracing)
+ * @return the buffer, null if t is or if allocation failed: nothing is recorded then
+ */
+trace_buffer_t *trace_buffer_new(trace_t *t);
+
+/**
+ * Record a span that just ended, see trace_span
+ */
+void trace_record(trace_buffer_t *b, trace_kind_t kind, u64 start, u32 n, u32 k);
+
+/**
+ * Write a trace as Chrome trace JSON, with complete ("X") events in microseconds: the
+ * thread is the buffer, and the graph index, n and k are the arguments
+ * @param t the trace
+ * @param out the stream to write to
+ */
+void trace_write(trace_t *t, FILE *out);
+
+/**
+ * The clock of the events
+ * @return nanoseconds on the monotonic clock
+ */
+static inline u64 trace_clock(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (u64) ts.tv_sec * 1000000000ULL + (u64) ts.tv_nsec;
+}
+
+/**
+ * The time a span starts at
+ * @param b the buffer (may be null)
+ * @return trace_clock(), 0 without a buffer
+ */
+static inline u64 trace_now(const trace_buffer_t *b) {
+    return NULL == b ? 0 : trace_clock();
+}
+
+/**
+ * Record a span that ends now. Without a buffer this is a single test, so that untraced
+ * runs pay nothing.
+ * @param b the buffer (may be null)
+ * @param kind what the thread was doing
+ * @param start what trace_now returned when it started
+ * @param n the number of vertices of the graph, 0 if not about a graph
+ * @param k the number of cops, 0 if not about a run
+ */
+static inline void trace_span(trace_buffer_t *b, trace_kind_t kind, u64 start, u32 n, u32 k) {
+    if (NULL != b) {
+        trace_record(b, kind, start, n, k);
+    }
+}
+
+/**
+ * Set the graph the events to come are about
+ * @param b the buffer (may be null)
+ * @param graph the index of the graph
+ */
+static inline void trace_graph(trace_buffer_t *b, u64 graph) {
+    if (NULL != b) {
+        b->graph = graph;
+    }
+}
+
+#endif //COPNV2_TRACE_H
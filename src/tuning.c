@@ -0,0 +1,86 @@
+#include "tuning.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char *engine_names[ENGINE_KINDS] = {
+        "auto",
+        "materialized",
+        "sweep",
+        "out-of-core",
+        "word",
+        "delta",
+        "retrograde",
+        "m4rm"
+};
+
+const char *engine_name(engine_t e) {
+    return e < ENGINE_KINDS ? engine_names[e] : "unknown";
+}
+
+bool engine_from_name(const char *name, engine_t *e) {
+    for (u32 i = 0; i < ENGINE_KINDS; ++i) {
+        if (0 == strcmp(name, engine_names[i])) {
+            *e = (engine_t) i;
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+void tuning_default(engine_tuning_t *t) {
+    // Building the tensor graph is quadratic in the number of states; on the machines
+    // we calibrated, the sweep won from the smallest graphs on
+    t->materialize_max_states_sparse = 0;
+    t->materialize_max_states_dense = 0;
+    t->dense_density = 0.5;
+}
+
+bool tuning_load(engine_tuning_t *t, const char *path) {
+    FILE *f = fopen(path, "r");
+    if (NULL == f) {
+        return FALSE;
+    }
+
+    bool ok = TRUE;
+    char *line = NULL;
+    size_t len = 0;
+    while (-1 != getline(&line, &len, f)) {
+        char key[64];
+        char value[64];
+
+        char *comment = strchr(line, '#');
+        if (NULL != comment) {
+            *comment = '\0';
+        }
+
+        if (2 != sscanf(line, " %63[a-z_] = %63s", key, value)) {
+            // Blank lines are fine, anything else is not
+            if (strspn(line, " \t\r\n") != strlen(line)) {
+                ok = FALSE;
+            }
+            continue;
+        }
+
+        if (0 == strcmp(key, "materialize_max_states_sparse")) {
+            t->materialize_max_states_sparse = strtoul(value, NULL, 10);
+        } else if (0 == strcmp(key, "materialize_max_states_dense")) {
+            t->materialize_max_states_dense = strtoul(value, NULL, 10);
+        } else if (0 == strcmp(key, "dense_density")) {
+            t->dense_density = strtod(value, NULL);
+        } else {
+            ok = FALSE;
+        }
+    }
+
+    free(line);
+    fclose(f);
+
+    return ok;
+}
+
+void tuning_write(engine_tuning_t *t, FILE *out) {
+    fprintf(out, "# Copper engine selection thresholds\n");
+    fprintf(out, "materialize_max_states_sparse = %u\n", t->materialize_max_states_sparse);
+    fprintf(out, "materialize_max_states_dense = %u\n", t->materialize_max_states_dense);
+    fprintf(out, "dense_density = %g\n", t->dense_density);
+}
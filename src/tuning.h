@@ -0,0 +1,80 @@
+#ifndef COPNV2_TUNING_H
+#define COPNV2_TUNING_H
+
+#include <stdio.h>
+#include "types.h"
+
+/**
+ * The ways bonato_al_algo2 can run the fixed point.
+ */
+typedef enum {
+    // Pick per graph and per k from the tuning thresholds
+    ENGINE_AUTO = 0,
+    // Build the tensor graph, FIFO worklist
+    ENGINE_MATERIALIZED,
+    // Enumerate tensor neighbours on the fly, index ordered sweeps, phi in memory
+    ENGINE_SWEEP,
+    // Same as the sweep, with phi in scratch files
+    ENGINE_OUT_OF_CORE,
+    // Same as the sweep, with rows and phi entries as single words (n <= 64)
+    ENGINE_WORD,
+    // Same as the sweep, propagating only what left the neighbourhood of phi, tracked by counters
+    ENGINE_DELTA,
+    // Backward induction on the states of the game, with a counter of escape moves per state
+    ENGINE_RETROGRADE,
+    // Rounds updating every position at once, as Boolean matrix products (Four Russians)
+    ENGINE_M4RM,
+    ENGINE_KINDS
+} engine_t;
+
+/**
+ * The thresholds the automatic engine selection uses. They depend on the host
+ * (caches, memory bandwidth), so they can be measured and saved to a file.
+ */
+typedef struct {
+    // Largest number of positions (n^k) for which the tensor graph is worth building,
+    // on sparse and on dense graphs
+    u32 materialize_max_states_sparse;
+    u32 materialize_max_states_dense;
+    // Edge density from which a graph counts as dense
+    double dense_density;
+} engine_tuning_t;
+
+/**
+ * The name of an engine, as used on the command line and in outputs
+ * @param e the engine
+ * @return a static string
+ */
+const char *engine_name(engine_t e);
+
+/**
+ * Parse an engine name
+ * @param name the name
+ * @param e where to store the engine
+ * @return if the name was known
+ */
+bool engine_from_name(const char *name, engine_t *e);
+
+/**
+ * Fill the tuning with defaults measured on a typical workstation
+ * @param t the tuning
+ */
+void tuning_default(engine_tuning_t *t);
+
+/**
+ * Read thresholds from a file of "key = value" lines ('#' starts a comment).
+ * Keys that are absent keep their current value.
+ * @param t the tuning
+ * @param path the file
+ * @return if the file could be read and every line was understood
+ */
+bool tuning_load(engine_tuning_t *t, const char *path);
+
+/**
+ * Write the thresholds in the format tuning_load reads
+ * @param t the tuning
+ * @param out the stream
+ */
+void tuning_write(engine_tuning_t *t, FILE *out);
+
+#endif //COPNV2_TUNING_H
@@ -6,9 +6,11 @@
 
 typedef unsigned char u8;
 typedef unsigned int u32;
+typedef unsigned long long u64;
 
 typedef signed char i8;
 typedef signed int i32;
+typedef signed long long i64;
 
 typedef u8 bool;
 
@@ -4,44 +4,226 @@
 
 #include "vertice_queue.h"
 #include <stdlib.h>
+#include <string.h>
 
-vertice_queue_t *vertice_queue_new(u32 cap) {
-    vertice_queue_t *q = malloc(sizeof(vertice_queue_t));
+static const char *worklist_names[WORKLIST_KINDS] = {
+        "auto",
+        "fifo",
+        "lifo",
+        "phi-size",
+        "shrink",
+        "rounds"
+};
+
+const char *worklist_name(worklist_policy_t p) {
+    return p < WORKLIST_KINDS ? worklist_names[p] : "unknown";
+}
+
+bool worklist_from_name(const char *name, worklist_policy_t *p) {
+    for (u32 i = 0; i < WORKLIST_KINDS; ++i) {
+        if (0 == strcmp(name, worklist_names[i])) {
+            *p = (worklist_policy_t) i;
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+bool worklist_keyed(worklist_policy_t p) {
+    return WORKLIST_PHI_SIZE == p || WORKLIST_SHRINK == p;
+}
+
+double vertice_queue_memory(u64 cap, worklist_policy_t p) {
+    double bytes = (double) cap / 8;
+
+    if (WORKLIST_ROUNDS != p) {
+        bytes += (double) cap * sizeof(u64);
+    }
+    if (worklist_keyed(p)) {
+        bytes += (double) cap * (sizeof(u32) + sizeof(u64));
+    }
+
+    return bytes;
+}
+
+vertice_queue_t *vertice_queue_new(u64 cap) {
+    return vertice_queue_new_in(NULL, cap);
+}
+
+vertice_queue_t *vertice_queue_new_in(arena_t *arena, u64 cap) {
+    return vertice_queue_new_policy_in(arena, cap, WORKLIST_FIFO);
+}
+
+vertice_queue_t *vertice_queue_new_policy_in(arena_t *arena, u64 cap, worklist_policy_t policy) {
+    vertice_queue_t *q = mem_alloc(arena, sizeof(vertice_queue_t));
 
     if (NULL == q) {
         return q;
     }
 
-    q->data = malloc(sizeof(u32) * cap);
-    q->b = new_bitset(cap);
-    bitset_all(q->b, 0);
+    bool keyed = worklist_keyed(policy);
+    q->arena = arena;
+    q->policy = WORKLIST_AUTO == policy ? WORKLIST_FIFO : policy;
+    // Sweeps walk the membership bitset; they need no list
+    q->data = WORKLIST_ROUNDS == policy ? NULL : mem_alloc_array(arena, cap, sizeof(u64));
+    q->key = keyed ? mem_alloc_array(arena, cap, sizeof(u32)) : NULL;
+    q->pos = keyed ? mem_alloc_array(arena, cap, sizeof(u64)) : NULL;
+    q->b = new_bitset_in(arena, cap);
+
+    if ((WORKLIST_ROUNDS != policy && NULL == q->data) || (keyed && (NULL == q->key || NULL == q->pos)) ||
+        NULL == q->b) {
+        if (NULL == arena) {
+            free(q->data);
+            free(q->key);
+            free(q->pos);
+            bitset_destroy(q->b);
+            free(q);
+        }
+        return NULL;
+    }
 
     q->lo = 0;
     q->hi = 0;
     q->sz = 0;
     q->cap = cap;
+    q->pops = 0;
 
     return q;
 }
 
 void vertice_queue_destroy(vertice_queue_t *q) {
+    if (NULL != q->arena) {
+        return;
+    }
     bitset_destroy(q->b);
     free(q->data);
+    free(q->key);
+    free(q->pos);
     free(q);
 }
 
-u32 vertice_queue_pop(vertice_queue_t *q) {
-    u32 e = q->data[q->lo];
-    q->lo = (q->lo + 1) % q->cap;
+/**
+ * Whether a comes out of a priority queue before b; ties go to the smaller element
+ */
+static bool heap_before(vertice_queue_t *q, u64 a, u64 b) {
+    if (q->key[a] != q->key[b]) {
+        return WORKLIST_PHI_SIZE == q->policy ? q->key[a] < q->key[b] : q->key[a] > q->key[b];
+    }
+    return a < b;
+}
+
+/**
+ * Move the element at a place of the heap towards the top until it is in order
+ */
+static void heap_up(vertice_queue_t *q, u64 at) {
+    u64 e = q->data[at];
+    while (at > 0) {
+        u64 parent = (at - 1) / 2;
+        if (!heap_before(q, e, q->data[parent])) {
+            break;
+        }
+        q->data[at] = q->data[parent];
+        q->pos[q->data[at]] = at;
+        at = parent;
+    }
+    q->data[at] = e;
+    q->pos[e] = at;
+}
+
+/**
+ * Move the element at a place of the heap towards the bottom until it is in order
+ */
+static void heap_down(vertice_queue_t *q, u64 at, u64 sz) {
+    u64 e = q->data[at];
+    while (TRUE) {
+        u64 child = 2 * at + 1;
+        if (child >= sz) {
+            break;
+        }
+        if (child + 1 < sz && heap_before(q, q->data[child + 1], q->data[child])) {
+            child++;
+        }
+        if (!heap_before(q, q->data[child], e)) {
+            break;
+        }
+        q->data[at] = q->data[child];
+        q->pos[q->data[at]] = at;
+        at = child;
+    }
+    q->data[at] = e;
+    q->pos[e] = at;
+}
+
+u64 vertice_queue_pop(vertice_queue_t *q) {
+    u64 e;
+
+    switch (q->policy) {
+        case WORKLIST_LIFO:
+            q->hi = (q->hi + q->cap - 1) % q->cap;
+            e = q->data[q->hi];
+            break;
+        case WORKLIST_PHI_SIZE:
+        case WORKLIST_SHRINK:
+            e = q->data[0];
+            if (q->sz > 1) {
+                q->data[0] = q->data[q->sz - 1];
+                heap_down(q, 0, q->sz - 1);
+            }
+            break;
+        case WORKLIST_ROUNDS: {
+            // The next element at or after the cursor, wrapping around to a new round
+            BITSET_DATA_UNIT *parts = q->b->parts;
+            u64 w = q->lo / BITSET_WIDTH;
+            BITSET_DATA_UNIT word = parts[w] & (~0U << (q->lo % BITSET_WIDTH));
+            while (0 == word) {
+                w = (w + 1) % q->b->l;
+                word = parts[w];
+            }
+            e = w * BITSET_WIDTH + __builtin_ctz(word);
+            q->lo = e + 1 == q->cap ? 0 : e + 1;
+            break;
+        }
+        default:
+            e = q->data[q->lo];
+            q->lo = (q->lo + 1) % q->cap;
+            break;
+    }
+
     q->sz--;
+    q->pops++;
     bitset_set(q->b, e, 0);
     return e;
 }
 
-void vertice_queue_push(vertice_queue_t *q, u32 e) {
-    if (!bitset_set(q->b, e, 1)) {
-        q->data[q->hi] = e;
-        q->hi = (q->hi + 1) % q->cap;
-        q->sz++;
+void vertice_queue_push(vertice_queue_t *q, u64 e) {
+    vertice_queue_push_keyed(q, e, 0);
+}
+
+void vertice_queue_push_keyed(vertice_queue_t *q, u64 e, u32 key) {
+    bool queued = bitset_set(q->b, e, 1);
+
+    switch (q->policy) {
+        case WORKLIST_PHI_SIZE:
+        case WORKLIST_SHRINK:
+            if (queued) {
+                // Either way, the element can only move towards the top
+                q->key[e] = WORKLIST_SHRINK == q->policy ? q->key[e] + key : key;
+                heap_up(q, q->pos[e]);
+            } else {
+                q->key[e] = key;
+                q->data[q->sz] = e;
+                heap_up(q, q->sz++);
+            }
+            break;
+        case WORKLIST_ROUNDS:
+            q->sz += !queued;
+            break;
+        default:
+            if (!queued) {
+                q->data[q->hi] = e;
+                q->hi = (q->hi + 1) % q->cap;
+                q->sz++;
+            }
+            break;
     }
 }
@@ -8,18 +8,95 @@
 #include "types.h"
 #include "bitset.h"
 
+/**
+ * The order in which a worklist hands its elements back. The number of pops the
+ * fixed point needs to converge depends heavily on it.
+ */
+typedef enum {
+    // Whatever the engine does by default (FIFO, or index ordered sweeps)
+    WORKLIST_AUTO = 0,
+    // First in, first out
+    WORKLIST_FIFO,
+    // Last in, first out
+    WORKLIST_LIFO,
+    // Smallest key first; keys only decrease while queued (the size of phi)
+    WORKLIST_PHI_SIZE,
+    // Largest key first; keys only increase while queued (how much phi shrank)
+    WORKLIST_SHRINK,
+    // Index ordered sweeps: elements pushed behind the cursor wait for the next round
+    WORKLIST_ROUNDS,
+    WORKLIST_KINDS
+} worklist_policy_t;
+
 typedef struct {
-    u32 lo, hi, sz, cap;
-    u32 *data;
+    u64 lo, hi, sz, cap;
+    u64 *data;
     bitset_t *b;
+    arena_t *arena;
+    worklist_policy_t policy;
+    // The priority policies: the key of each element, and where it is in the heap (data)
+    u32 *key;
+    u64 *pos;
+    // The number of elements popped so far
+    u64 pops;
 } vertice_queue_t;
 
-vertice_queue_t *vertice_queue_new(u32 cap);
+/**
+ * The name of a policy, as used on the command line
+ * @param p the policy
+ * @return a static string
+ */
+const char *worklist_name(worklist_policy_t p);
+
+/**
+ * Parse a policy name
+ * @param name the name
+ * @param p where to store the policy
+ * @return if the name was known
+ */
+bool worklist_from_name(const char *name, worklist_policy_t *p);
+
+/**
+ * Whether the elements pushed in a queue of this policy need a key
+ * @param p the policy
+ */
+bool worklist_keyed(worklist_policy_t p);
+
+/**
+ * The bytes a queue takes
+ * @param cap the number of elements
+ * @param p the policy
+ * @return the estimate, in bytes, as a double since it may be past what size_t holds
+ */
+double vertice_queue_memory(u64 cap, worklist_policy_t p);
+
+vertice_queue_t *vertice_queue_new(u64 cap);
+
+vertice_queue_t *vertice_queue_new_in(arena_t *arena, u64 cap);
+
+/**
+ * Create a queue of elements 0 .. cap - 1 handed back in the order of a policy
+ * @param arena the arena (or null for the heap)
+ * @param cap the number of elements
+ * @param policy the policy (WORKLIST_AUTO is FIFO)
+ * @return the queue, or null if allocation failed
+ */
+vertice_queue_t *vertice_queue_new_policy_in(arena_t *arena, u64 cap, worklist_policy_t policy);
 
 void vertice_queue_destroy(vertice_queue_t *q);
 
-u32 vertice_queue_pop(vertice_queue_t *q);
+u64 vertice_queue_pop(vertice_queue_t *q);
+
+void vertice_queue_push(vertice_queue_t *q, u64 e);
 
-void vertice_queue_push(vertice_queue_t *q, u32 e);
+/**
+ * Push an element with its key (see worklist_policy_t). If it is already queued, the
+ * key is updated: replaced for WORKLIST_PHI_SIZE, added to for WORKLIST_SHRINK.
+ * Policies without keys ignore it.
+ * @param q the queue
+ * @param e the element
+ * @param key the key
+ */
+void vertice_queue_push_keyed(vertice_queue_t *q, u64 e, u32 key);
 
 #endif //COPNV2_VERTICE_QUEUE_H
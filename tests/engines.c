@@ -0,0 +1,226 @@
+/*
+ * Every engine, with and without dominance pruning, finds the known cop numbers of a
+ * small fixed set of graphs, and the certificates it writes hold: each cop move is
+ * along the tensor graph, every robber reply is answered, and no play goes round in
+ * a cycle (so the robber is always captured).
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "copper.h"
+#include "graph6.h"
+#include "solver.h"
+
+#define MAX_K 4
+
+typedef struct {
+    const char *name;
+    const char *g6;
+    u32 cop_number;
+} known_t;
+
+static const known_t graphs[] = {
+        {"C4",         "Cl",                    2},
+        {"C5",         "Dhc",                   2},
+        {"C7",         "FhCKG",                 2},
+        {"P6",         "EhCG",                  1},
+        {"star K1,5",  "Esa?",                  1},
+        {"binary 7",   "FqO`?",                 1},
+        {"grid 3x3",   "HkSg_SD",               2},
+        {"grid 3x4",   "Kh`HGcG@GC_H",          2},
+        {"grid 4x4",   "Oh`HGcG@GC_H?G?C_@G?H", 2},
+        {"K5",         "D~{",                   1},
+        {"P3 + P3",    "EgCG",                  2},
+        {"Petersen",   "IheA@GUAo",             3}
+};
+
+#define GRAPHS (sizeof(graphs) / sizeof(graphs[0]))
+
+/**
+ * Whether two vertices are adjacent (the graph is reflexive)
+ */
+static bool adjacent(graph_t *g, u32 a, u32 b) {
+    return EDGE == edge_get_and_set(g, a, b, -1);
+}
+
+/**
+ * Follow a certificate from every robber start, checking every state it reaches
+ * @param g the graph
+ * @param cert the certificate
+ * @param what the graph and engine, for the messages
+ * @return if the certificate holds
+ */
+static bool check_certificate(graph_t *g, certificate_t *cert, const char *what) {
+    u32 n = g->n;
+    u8 k = cert->k;
+    size_t states = (size_t) cert->N * n;
+    bool ok = TRUE;
+
+    // 0 unseen, 1 on the current play, 2 done
+    u8 *color = calloc(states, 1);
+    // The play being followed, and the next robber reply to try at each of its states
+    size_t *play = malloc(sizeof(size_t) * states);
+    u32 *reply = malloc(sizeof(u32) * states);
+    u32 *T = malloc(sizeof(u32) * k);
+    u32 *T_next = malloc(sizeof(u32) * k);
+
+    for (u32 u = 0; ok && u < n; ++u) {
+        size_t s = (size_t) cert->start * n + u;
+        if (0 != color[s]) {
+            continue;
+        }
+
+        size_t depth = 0;
+        play[depth] = s;
+        reply[depth++] = 0;
+        color[s] = 1;
+
+        while (ok && depth > 0) {
+            s = play[depth - 1];
+            u64 move = cert->strategy[s];
+            u32 robber = s % n;
+            int_to_tuple(k, T, n, s / n);
+
+            if (0 == reply[depth - 1]) {
+                // First time at this state: the cops' answer must be legal
+                if (CERT_NO_MOVE == move) {
+                    bool capture = FALSE;
+                    for (u8 c = 0; c < k; ++c) {
+                        capture |= adjacent(g, T[c], robber);
+                    }
+                    if (!capture) {
+                        printf("%s: no move, but no cop next to the robber on %u.\n", what, robber);
+                        ok = FALSE;
+                    }
+                } else if (move >= cert->N) {
+                    printf("%s: the cops move to a position out of range.\n", what);
+                    ok = FALSE;
+                } else {
+                    int_to_tuple(k, T_next, n, move);
+                    for (u8 c = 0; c < k; ++c) {
+                        if (!adjacent(g, T[c], T_next[c])) {
+                            printf("%s: cop %u moves from %u to %u, which are not adjacent.\n",
+                                   what, c, T[c], T_next[c]);
+                            ok = FALSE;
+                        }
+                    }
+                }
+            }
+
+            // The robber's replies, one at a time
+            u32 w = reply[depth - 1];
+            if (CERT_NO_MOVE != move) {
+                while (w < n && !adjacent(g, robber, w)) {
+                    w++;
+                }
+            } else {
+                w = n;
+            }
+
+            if (!ok || w >= n) {
+                color[s] = 2;
+                depth--;
+                continue;
+            }
+
+            reply[depth - 1] = w + 1;
+            size_t t = (size_t) move * n + w;
+            if (1 == color[t]) {
+                printf("%s: the robber can go round a cycle through %u.\n", what, w);
+                ok = FALSE;
+            } else if (0 == color[t]) {
+                color[t] = 1;
+                play[depth] = t;
+                reply[depth++] = 0;
+            }
+        }
+    }
+
+    free(T_next);
+    free(T);
+    free(reply);
+    free(play);
+    free(color);
+
+    return ok;
+}
+
+int main(void) {
+    const char *scratch = getenv("TMPDIR");
+    if (NULL == scratch) {
+        scratch = "/tmp";
+    }
+
+    engine_tuning_t tuning;
+    tuning_default(&tuning);
+
+    u32 failures = 0;
+    for (u32 i = 0; i < GRAPHS; ++i) {
+        copper_graph_t *cg = copper_graph_from_g6(graphs[i].g6, strlen(graphs[i].g6));
+        char g6[64];
+        strcpy(g6, graphs[i].g6);
+        graph_t *g = from_g6(g6);
+        if (NULL == cg || NULL == g) {
+            printf("%s: failed to decode the graph.\n", graphs[i].name);
+            return 1;
+        }
+
+        for (u32 e = 0; e < ENGINE_KINDS; ++e) {
+            for (int dominance = 0; dominance <= 1; ++dominance) {
+                char what[128];
+                snprintf(what, sizeof(what), "%s, %s engine%s", graphs[i].name, engine_name((engine_t) e),
+                         dominance ? ", dominance" : "");
+
+                // The answer, through the library
+                copper_options_t options;
+                copper_options_default(&options);
+                options.max_k = MAX_K;
+                options.engine = engine_name((engine_t) e);
+                options.scratch_dir = scratch;
+                options.dominance = dominance;
+
+                copper_result_t result;
+                copper_status_t status = copper_cop_number(cg, &options, &result);
+                if (COPPER_OK != status || graphs[i].cop_number != result.cop_number) {
+                    printf("%s: expected %u, got status %d and cop number %u.\n",
+                           what, graphs[i].cop_number, status, result.cop_number);
+                    failures++;
+                }
+
+                // The strategy, which only the solver gives: the fixed point runs up to the answer
+                certificate_t cert = {0};
+                solver_ctx_t ctx = {
+                        .cert = &cert,
+                        .scratch_dir = scratch,
+                        .resident_budget = 1U << 30,
+                        .engine = (engine_t) e,
+                        .tuning = &tuning,
+                        .decided = BOUND_NONE,
+                        .quiet = TRUE,
+                        .worklist = WORKLIST_AUTO,
+                        .dominance = dominance
+                };
+                u32 k = cop_number(g, MAX_K, &ctx);
+                if (graphs[i].cop_number != k) {
+                    printf("%s: expected %u with a certificate, got %u.\n", what, graphs[i].cop_number, k);
+                    failures++;
+                } else if (NULL == cert.strategy || cert.k != k) {
+                    printf("%s: no certificate for k = %u.\n", what, k);
+                    failures++;
+                } else if (!check_certificate(g, &cert, what)) {
+                    failures++;
+                }
+                certificate_clear(&cert);
+            }
+        }
+
+        destroy_graph(g);
+        copper_graph_destroy(cg);
+    }
+
+    if (0 != failures) {
+        printf("%u failures.\n", failures);
+        return 1;
+    }
+    return 0;
+}
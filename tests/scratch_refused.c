@@ -0,0 +1,32 @@
+/*
+ * A run whose scratch storage cannot be mapped is refused: its k is unknown, and the
+ * cop number must not be reported as a higher one.
+ */
+#include <stdio.h>
+#include "copper.h"
+
+int main(void) {
+    // The Petersen graph, cop number 3
+    const char petersen[] = "IheA@GUAo";
+    copper_graph_t *g = copper_graph_from_g6(petersen, sizeof(petersen) - 1);
+    if (NULL == g) {
+        printf("Failed to decode the graph.\n");
+        return 1;
+    }
+
+    copper_options_t options;
+    copper_options_default(&options);
+    options.engine = "out-of-core";
+    options.scratch_dir = "/nonexistent_dir/copper";
+    options.resident_budget = 0;
+
+    copper_result_t result;
+    copper_status_t status = copper_cop_number(g, &options, &result);
+    copper_graph_destroy(g);
+
+    if (COPPER_REFUSED != status) {
+        printf("Expected the run to be refused, got status %d and cop number %u.\n", status, result.cop_number);
+        return 1;
+    }
+    return 0;
+}